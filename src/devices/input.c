@@ -1,52 +1,115 @@
 #include "devices/input.h"
 #include <debug.h>
-#include "devices/intq.h"
+#include "devices/ring.h"
 #include "devices/serial.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
 
-/* Stores keys from the keyboard and serial port. */
-static struct intq buffer;
+/* Input buffer size, in bytes.  Must be a power of 2. */
+#define INPUT_BUFSIZE 256
+
+/* Stores keys from the keyboard and serial port.
+
+   The keyboard and serial interrupt handlers are the producers.
+   External interrupts never nest, so they never run at the same
+   time as each other.  Kernel threads are the consumers, and
+   they take turns via read_lock. */
+static uint8_t buffer_data[INPUT_BUFSIZE];
+static struct ring buffer;
+static struct lock read_lock;
+
+/* Upped by input_putc() when the buffer goes from empty to
+   non-empty while a reader is waiting for it. */
+static struct semaphore not_empty;
+static volatile bool reader_waiting;
+
+static void wait_not_empty (void);
 
 /* Initializes the input buffer. */
 void
-input_init (void) 
+input_init (void)
 {
-  intq_init (&buffer);
+  ring_init (&buffer, buffer_data, sizeof buffer_data);
+  lock_init_named (&read_lock, "input");
+  sema_init (&not_empty, 0);
 }
 
 /* Adds a key to the input buffer.
    Interrupts must be off and the buffer must not be full. */
 void
-input_putc (uint8_t key) 
+input_putc (uint8_t key)
 {
+  bool was_empty;
+
   ASSERT (intr_get_level () == INTR_OFF);
-  ASSERT (!intq_full (&buffer));
+  ASSERT (!ring_full (&buffer));
 
-  intq_putc (&buffer, key);
+  was_empty = ring_empty (&buffer);
+  ring_putc (&buffer, key);
+  if (was_empty && reader_waiting)
+    {
+      reader_waiting = false;
+      sema_up (&not_empty);
+    }
   serial_notify ();
 }
 
 /* Retrieves a key from the input buffer.
    If the buffer is empty, waits for a key to be pressed. */
 uint8_t
-input_getc (void) 
+input_getc (void)
 {
-  enum intr_level old_level;
   uint8_t key;
 
-  old_level = intr_disable ();
-  key = intq_getc (&buffer);
-  serial_notify ();
-  intr_set_level (old_level);
-  
+  input_read (&key, 1);
   return key;
 }
 
+/* Reads SIZE keys from the input buffer into BUF, waiting for
+   more keys to be pressed as necessary.  Keys already in the
+   buffer are copied out in bulk. */
+void
+input_read (void *buf_, size_t size)
+{
+  uint8_t *buf = buf_;
+  size_t ofs = 0;
+
+  lock_acquire (&read_lock);
+  while (ofs < size)
+    {
+      size_t n = ring_get (&buffer, buf + ofs, size - ofs);
+      if (n > 0)
+        {
+          /* We made room, so receive interrupts may resume. */
+          enum intr_level old_level = intr_disable ();
+          serial_notify ();
+          intr_set_level (old_level);
+          ofs += n;
+        }
+      else
+        wait_not_empty ();
+    }
+  lock_release (&read_lock);
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
 bool
-input_full (void) 
+input_full (void)
 {
   ASSERT (intr_get_level () == INTR_OFF);
-  return intq_full (&buffer);
+  return ring_full (&buffer);
+}
+
+/* Sleeps until the input buffer is probably non-empty.
+   A wakeup may be stale, so the caller must recheck. */
+static void
+wait_not_empty (void)
+{
+  reader_waiting = true;
+  barrier ();
+  if (ring_empty (&buffer))
+    sema_down (&not_empty);
+  reader_waiting = false;
 }
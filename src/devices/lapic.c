@@ -0,0 +1,121 @@
+#include "devices/lapic.h"
+#include <debug.h>
+#include <stdint.h>
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/vaddr.h"
+
+/* See [IA32-v3a] chapter 10 "Advanced Programmable Interrupt
+   Controller (APIC)" and section 8.4 "Multiple-Processor (MP)
+   Initialization". */
+
+/* Kernel virtual address at which the local APIC's registers
+   are mapped.  Every CPU's local APIC answers at the same
+   address. */
+#define LAPIC_VADDR 0xfee00000
+
+/* Register offsets. */
+#define LAPIC_ID      0x020     /* Local APIC ID. */
+#define LAPIC_ICR_LO  0x300     /* Interrupt command, low word. */
+#define LAPIC_ICR_HI  0x310     /* Interrupt command, high word. */
+
+/* Interrupt command register bits. */
+#define ICR_INIT       0x00000500 /* INIT delivery mode. */
+#define ICR_STARTUP    0x00000600 /* Start-up delivery mode. */
+#define ICR_PENDING    0x00001000 /* Delivery status: send pending. */
+#define ICR_ASSERT     0x00004000 /* Level: assert. */
+#define ICR_LEVEL      0x00008000 /* Trigger mode: level. */
+#define ICR_ALL_BUT_ME 0x000c0000 /* Destination: all but self. */
+
+/* CPUID feature flag: the CPU has a local APIC. */
+#define CPUID_APIC (1 << 9)
+
+/* Model-specific register holding the local APIC's physical
+   address and its global enable bit. */
+#define MSR_APIC_BASE 0x1b
+#define APIC_BASE_ENABLE 0x800
+
+static volatile uint32_t *lapic;
+
+/* Returns the local APIC register at byte offset REG. */
+static inline volatile uint32_t *
+lapic_reg (unsigned reg)
+{
+  return lapic + reg / sizeof *lapic;
+}
+
+/* Sends the interprocessor interrupt described by ICR_LO to
+   every CPU but this one, and waits for it to be delivered. */
+static void
+send_ipi (uint32_t icr_lo)
+{
+  *lapic_reg (LAPIC_ICR_HI) = 0;
+  *lapic_reg (LAPIC_ICR_LO) = icr_lo;
+  while (*lapic_reg (LAPIC_ICR_LO) & ICR_PENDING)
+    continue;
+}
+
+/* Maps the running CPU's local APIC into the kernel page
+   directory, so that any CPU using that page directory can
+   reach its own.  Returns false, without mapping anything, if
+   the CPU has no local APIC or it is disabled. */
+bool
+lapic_init (void)
+{
+  uint32_t eax, ebx, ecx, edx;
+  uint32_t base_lo, base_hi;
+  uint32_t *pt;
+
+  asm volatile ("cpuid"
+                : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+                : "a" (1));
+  if (!(edx & CPUID_APIC))
+    return false;
+
+  asm volatile ("rdmsr" : "=a" (base_lo), "=d" (base_hi)
+                : "c" (MSR_APIC_BASE));
+  if (!(base_lo & APIC_BASE_ENABLE) || base_hi != 0)
+    return false;
+
+  /* The registers must not be cached, so set PCD and PWT. */
+  ASSERT (init_page_dir[pd_no ((void *) LAPIC_VADDR)] == 0);
+  pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+  pt[pt_no ((void *) LAPIC_VADDR)] = ((base_lo & PTE_ADDR)
+                                      | PTE_PCD | PTE_PWT | PTE_W | PTE_P);
+  init_page_dir[pd_no ((void *) LAPIC_VADDR)] = pde_create (pt);
+  lapic = (volatile uint32_t *) LAPIC_VADDR;
+  return true;
+}
+
+/* Returns the running CPU's local APIC ID. */
+unsigned
+lapic_id (void)
+{
+  ASSERT (lapic != NULL);
+
+  return *lapic_reg (LAPIC_ID) >> 24;
+}
+
+/* Sends an INIT interprocessor interrupt to every other CPU,
+   which resets it and leaves it waiting for a start-up
+   interrupt. */
+void
+lapic_send_init (void)
+{
+  ASSERT (lapic != NULL);
+
+  send_ipi (ICR_ALL_BUT_ME | ICR_LEVEL | ICR_ASSERT | ICR_INIT);
+}
+
+/* Sends a start-up interprocessor interrupt to every other CPU,
+   which starts it in real mode at PADDR.  PADDR must be
+   page-aligned and below 1 MB. */
+void
+lapic_send_startup (uintptr_t paddr)
+{
+  ASSERT (lapic != NULL);
+  ASSERT (paddr % PGSIZE == 0 && paddr < 0x100000);
+
+  send_ipi (ICR_ALL_BUT_ME | ICR_ASSERT | ICR_STARTUP | (paddr / PGSIZE));
+}
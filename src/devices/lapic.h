@@ -0,0 +1,16 @@
+#ifndef DEVICES_LAPIC_H
+#define DEVICES_LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Local APIC, the interrupt controller that each CPU has.  We
+   use it only to start the other CPUs.  Interrupts still come
+   through the 8259A PIC. */
+
+bool lapic_init (void);
+unsigned lapic_id (void);
+void lapic_send_init (void);
+void lapic_send_startup (uintptr_t paddr);
+
+#endif /* devices/lapic.h */
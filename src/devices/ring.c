@@ -0,0 +1,158 @@
+#include "devices/ring.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/synch.h"
+
+static void copy_in (struct ring *, size_t pos, const uint8_t *, size_t);
+static void copy_out (const struct ring *, size_t pos, uint8_t *, size_t);
+
+/* Initializes ring R to use the CAPACITY bytes in BUF.
+   CAPACITY must be a power of 2. */
+void
+ring_init (struct ring *r, void *buf, size_t capacity)
+{
+  ASSERT (r != NULL);
+  ASSERT (buf != NULL);
+  ASSERT (capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+  r->buf = buf;
+  r->mask = capacity - 1;
+  r->head = r->tail = 0;
+}
+
+/* Returns the number of bytes in R. */
+size_t
+ring_count (const struct ring *r)
+{
+  return r->head - r->tail;
+}
+
+/* Returns the number of bytes that may be added to R before it
+   is full. */
+size_t
+ring_space (const struct ring *r)
+{
+  return r->mask + 1 - ring_count (r);
+}
+
+/* Returns true if R is empty, false otherwise. */
+bool
+ring_empty (const struct ring *r)
+{
+  return r->head == r->tail;
+}
+
+/* Returns true if R is full, false otherwise. */
+bool
+ring_full (const struct ring *r)
+{
+  return ring_count (r) > r->mask;
+}
+
+/* Adds BYTE to the end of R.  Returns true if successful, false
+   if R is full.  Must only be called by R's producer. */
+bool
+ring_putc (struct ring *r, uint8_t byte)
+{
+  size_t head = r->head;
+
+  if (head - r->tail > r->mask)
+    return false;
+  r->buf[head & r->mask] = byte;
+
+  /* Publish the byte before the new head. */
+  barrier ();
+  r->head = head + 1;
+  return true;
+}
+
+/* Removes a byte from R and stores it in *BYTE.  Returns true if
+   successful, false if R is empty.  Must only be called by R's
+   consumer. */
+bool
+ring_getc (struct ring *r, uint8_t *byte)
+{
+  size_t tail = r->tail;
+
+  if (tail == r->head)
+    return false;
+
+  /* Read the byte only after observing the head that covers
+     it, and release the slot only after reading it. */
+  barrier ();
+  *byte = r->buf[tail & r->mask];
+  barrier ();
+  r->tail = tail + 1;
+  return true;
+}
+
+/* Adds up to SIZE bytes from BUF to the end of R.  Returns the
+   number of bytes added, which is less than SIZE only if R
+   fills up.  Must only be called by R's producer. */
+size_t
+ring_put (struct ring *r, const void *buf, size_t size)
+{
+  size_t head = r->head;
+  size_t space = r->mask + 1 - (head - r->tail);
+
+  if (size > space)
+    size = space;
+  if (size == 0)
+    return 0;
+  copy_in (r, head, buf, size);
+
+  barrier ();
+  r->head = head + size;
+  return size;
+}
+
+/* Removes up to SIZE bytes from R into BUF.  Returns the number
+   of bytes removed, which is less than SIZE only if R runs out
+   of data.  Must only be called by R's consumer. */
+size_t
+ring_get (struct ring *r, void *buf, size_t size)
+{
+  size_t tail = r->tail;
+  size_t count = r->head - tail;
+
+  if (size > count)
+    size = count;
+  if (size == 0)
+    return 0;
+
+  barrier ();
+  copy_out (r, tail, buf, size);
+  barrier ();
+  r->tail = tail + size;
+  return size;
+}
+
+/* Copies SIZE bytes from SRC into R's buffer starting at
+   free-running position POS, wrapping around the end of the
+   buffer if necessary. */
+static void
+copy_in (struct ring *r, size_t pos, const uint8_t *src, size_t size)
+{
+  size_t ofs = pos & r->mask;
+  size_t chunk = r->mask + 1 - ofs;
+
+  if (chunk > size)
+    chunk = size;
+  memcpy (r->buf + ofs, src, chunk);
+  memcpy (r->buf, src + chunk, size - chunk);
+}
+
+/* Copies SIZE bytes out of R's buffer starting at free-running
+   position POS into DST, wrapping around the end of the buffer
+   if necessary. */
+static void
+copy_out (const struct ring *r, size_t pos, uint8_t *dst, size_t size)
+{
+  size_t ofs = pos & r->mask;
+  size_t chunk = r->mask + 1 - ofs;
+
+  if (chunk > size)
+    chunk = size;
+  memcpy (dst, r->buf + ofs, chunk);
+  memcpy (dst + chunk, r->buf, size - chunk);
+}
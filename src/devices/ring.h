@@ -0,0 +1,49 @@
+#ifndef DEVICES_RING_H
+#define DEVICES_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* A single-producer, single-consumer ring buffer of bytes,
+   shared between kernel threads and external interrupt
+   handlers.
+
+   Exactly one context may put bytes into a ring and exactly one
+   context may take bytes out of it at any given time.  Under
+   that rule no locking is needed: the producer only ever writes
+   `head' and the consumer only ever writes `tail', and each
+   publishes its update with a memory barrier after touching the
+   buffer.  Callers with more than one producer or consumer must
+   serialize them externally, e.g. with a lock among kernel
+   threads.
+
+   `head' and `tail' are free-running counters that are reduced
+   modulo the capacity only when indexing the buffer, so the
+   capacity must be a power of 2 and the ring can hold all of
+   its bytes (no slot is sacrificed to tell full from empty).
+
+   None of the ring functions sleep.  Waiting for data or space
+   is left to the caller, which typically keeps a semaphore that
+   it ups only when the ring goes from empty to non-empty (or
+   full to non-full). */
+struct ring
+  {
+    uint8_t *buf;               /* Buffer of CAPACITY bytes. */
+    size_t mask;                /* Capacity minus 1. */
+    volatile size_t head;       /* Count of bytes ever put. */
+    volatile size_t tail;       /* Count of bytes ever taken. */
+  };
+
+void ring_init (struct ring *, void *buf, size_t capacity);
+size_t ring_count (const struct ring *);
+size_t ring_space (const struct ring *);
+bool ring_empty (const struct ring *);
+bool ring_full (const struct ring *);
+
+bool ring_putc (struct ring *, uint8_t);
+bool ring_getc (struct ring *, uint8_t *);
+size_t ring_put (struct ring *, const void *, size_t);
+size_t ring_get (struct ring *, void *, size_t);
+
+#endif /* devices/ring.h */
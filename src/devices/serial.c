@@ -1,7 +1,7 @@
 #include "devices/serial.h"
 #include <debug.h>
 #include "devices/input.h"
-#include "devices/intq.h"
+#include "devices/ring.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
@@ -51,13 +51,29 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/* Transmit queue size, in bytes.  Must be a power of 2. */
+#define TXQ_BUFSIZE 512
+
+/* Data to be transmitted.
+   Kernel threads put bytes into the queue with interrupts off.
+   The serial interrupt handler takes them out, except that a
+   writer that cannot wait (or serial_flush()) drains the queue
+   itself by polling, which is safe because interrupts are off
+   at the time. */
+static uint8_t txq_data[TXQ_BUFSIZE];
+static struct ring txq;
+
+/* Writers waiting for room in the transmit queue.
+   Once the interrupt handler makes room, the serial softirq
+   wakes them all. */
+static struct semaphore txq_not_full;
+static int writers_waiting;
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
 static void write_ier (void);
 static intr_handler_func serial_interrupt;
+static softirq_func serial_softirq;
 
 /* Initializes the serial port device for polling mode.
    Polling mode busy-waits for the serial port to become free
@@ -71,7 +87,8 @@ init_poll (void)
   outb (FCR_REG, 0);                    /* Disable FIFO. */
   set_serial (9600);                    /* 9.6 kbps, N-8-1. */
   outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-  intq_init (&txq);
+  ring_init (&txq, txq_data, sizeof txq_data);
+  sema_init (&txq_not_full, 0);
   mode = POLL;
 } 
 
@@ -88,6 +105,7 @@ serial_init_queue (void)
   ASSERT (mode == POLL);
 
   intr_register_ext (0x20 + 4, serial_interrupt, "serial");
+  softirq_register (SOFTIRQ_SERIAL, serial_softirq, "serial");
   mode = QUEUE;
   old_level = intr_disable ();
   write_ier ();
@@ -97,33 +115,62 @@ serial_init_queue (void)
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) 
+{
+  serial_putbuf (&byte, 1);
+}
+
+/* Sends the N bytes in BUFFER to the serial port.  Interrupts
+   are turned off once for the whole buffer, and as many bytes as
+   fit are queued at a time, instead of paying for both on every
+   byte. */
+void
+serial_putbuf (const uint8_t *buffer, size_t n) 
 {
   enum intr_level old_level = intr_disable ();
 
   if (mode != QUEUE)
     {
       /* If we're not set up for interrupt-driven I/O yet,
-         use dumb polling to transmit a byte. */
+         use dumb polling to transmit the bytes. */
       if (mode == UNINIT)
         init_poll ();
-      putc_poll (byte); 
+      while (n-- > 0)
+        putc_poll (*buffer++); 
     }
   else 
     {
-      /* Otherwise, queue a byte and update the interrupt enable
-         register. */
-      if (old_level == INTR_OFF && intq_full (&txq)) 
+      for (;;)
         {
-          /* Interrupts are off and the transmit queue is full.
-             If we wanted to wait for the queue to empty,
-             we'd have to reenable interrupts.
-             That's impolite, so we'll send a character via
-             polling instead. */
-          putc_poll (intq_getc (&txq)); 
+          /* Queue as many bytes as fit and update the interrupt
+             enable register. */
+          size_t cnt = ring_put (&txq, buffer, n);
+          buffer += cnt;
+          n -= cnt;
+          write_ier ();
+          if (n == 0)
+            break;
+
+          /* The transmit queue is full. */
+          if (old_level == INTR_OFF || softirq_context ())
+            {
+              /* Interrupts are off, or we are in a softirq, which
+                 cannot sleep.  If we wanted to wait for the queue
+                 to empty, we'd have to reenable interrupts.
+                 That's impolite, so we'll send a character via
+                 polling instead. */
+              uint8_t c;
+              ring_getc (&txq, &c);
+              putc_poll (c);
+            }
+          else
+            {
+              /* Wait for the interrupt handler to make room.
+                 Transmit interrupts are already enabled, because
+                 the queue is not empty. */
+              writers_waiting++;
+              sema_down (&txq_not_full);
+            }
         }
-
-      intq_putc (&txq, byte); 
-      write_ier ();
     }
   
   intr_set_level (old_level);
@@ -135,8 +182,10 @@ void
 serial_flush (void) 
 {
   enum intr_level old_level = intr_disable ();
-  while (!intq_empty (&txq))
-    putc_poll (intq_getc (&txq));
+  uint8_t c;
+
+  while (ring_getc (&txq, &c))
+    putc_poll (c);
   intr_set_level (old_level);
 }
 
@@ -182,7 +231,7 @@ write_ier (void)
 
   /* Enable transmit interrupt if we have any characters to
      transmit. */
-  if (!intq_empty (&txq))
+  if (!ring_empty (&txq))
     ier |= IER_XMIT;
 
   /* Enable receive interrupt if we have room to store any
@@ -220,9 +269,38 @@ serial_interrupt (struct intr_frame *f UNUSED)
 
   /* As long as we have a byte to transmit, and the hardware is
      ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
-    outb (THR_REG, intq_getc (&txq));
+  while (!ring_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
+    {
+      uint8_t c;
+      ring_getc (&txq, &c);
+      outb (THR_REG, c);
+    }
+
+  /* Wake up writers waiting for room in the queue, after
+     returning. */
+  if (!ring_full (&txq) && writers_waiting > 0)
+    softirq_raise (SOFTIRQ_SERIAL);
 
   /* Update interrupt enable register based on queue status. */
   write_ier ();
 }
+
+/* Serial softirq: wakes up the writers waiting for room in the
+   transmit queue, turning interrupts off only to claim each
+   one. */
+static void
+serial_softirq (void) 
+{
+  for (;;) 
+    {
+      enum intr_level old_level = intr_disable ();
+      bool wake = writers_waiting > 0 && !ring_full (&txq);
+      if (wake)
+        writers_waiting--;
+      intr_set_level (old_level);
+
+      if (!wake)
+        break;
+      sema_up (&txq_not_full);
+    }
+}
@@ -4,10 +4,18 @@
 #include "devices/kbd.h"
 #include "devices/serial.h"
 #include "devices/timer.h"
+#include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/palloc.h"
+#include "threads/profile.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
+#include "userprog/syscall.h"
 #endif
 #ifdef FILESYS
 #include "devices/block.h"
@@ -94,6 +102,8 @@ shutdown_power_off (void)
   filesys_done ();
 #endif
 
+  trace_dump ();
+  profile_dump ();
   print_stats ();
 
   printf ("Powering off...\n");
@@ -120,12 +130,20 @@ print_stats (void)
 {
   timer_print_stats ();
   thread_print_stats ();
+  intr_print_stats ();
+  workqueue_print_stats ();
+  kmem_cache_print_stats ();
+  palloc_print_stats ();
 #ifdef FILESYS
   block_print_stats ();
 #endif
   console_print_stats ();
   kbd_print_stats ();
+#ifdef LOCKSTAT
+  lock_print_stats ();
+#endif
 #ifdef USERPROG
   exception_print_stats ();
+  syscall_print_stats ();
 #endif
 }
@@ -5,8 +5,11 @@
 #include <stdio.h>
 #include "devices/pit.h"
 #include "threads/interrupt.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/tsc.h"
+#include "threads/workqueue.h"
   
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -25,11 +28,32 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Number of nanoseconds in a timer tick. */
+#define NS_PER_TICK (1000 * 1000 * 1000 / TIMER_FREQ)
+
+/* Clock source for timer_now(), initialized by timer_calibrate():
+   the time-stamp counter ran at TSC_HZ cycles per second and
+   read BASE_TSC at BASE_NS nanoseconds after boot.  Until then,
+   TSC_HZ is 0 and timer_now() counts whole ticks. */
+static uint64_t tsc_hz;
+static uint64_t base_tsc;
+static uint64_t base_ns;
+
+/* Number of timer ticks over which to calibrate the TSC. */
+#define TSC_CALIBRATE_TICKS (TIMER_FREQ / 10 > 0 ? TIMER_FREQ / 10 : 1)
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
 static void real_time_delay (int64_t num, int32_t denom);
+static void calibrate_tsc (void);
+static softirq_func timer_softirq;
+
+/* Set by the timer interrupt when the MLFQS load average and
+   recent_cpu values are due for their once-per-second update.
+   Access with interrupts off. */
+static bool mlfqs_new_second;
 
 /* Sets up the timer to interrupt TIMER_FREQ times per second,
    and registers the corresponding interrupt. */
@@ -38,6 +62,7 @@ timer_init (void)
 {
   pit_configure_channel (0, 2, TIMER_FREQ);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+  softirq_register (SOFTIRQ_TIMER, timer_softirq, "timer");
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -65,6 +90,35 @@ timer_calibrate (void)
       loops_per_tick |= test_bit;
 
   printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+  calibrate_tsc ();
+}
+
+/* Measures the TSC's frequency against the timer, to make it
+   the clock source for timer_now(). */
+static void
+calibrate_tsc (void) 
+{
+  int64_t start;
+  uint64_t start_tsc, end_tsc;
+
+  /* Start counting right after a tick. */
+  start = ticks;
+  while (ticks == start)
+    barrier ();
+  start = ticks;
+  start_tsc = rdtsc ();
+
+  while (ticks - start < TSC_CALIBRATE_TICKS)
+    barrier ();
+  end_tsc = rdtsc ();
+
+  base_tsc = end_tsc;
+  base_ns = (uint64_t) (start + TSC_CALIBRATE_TICKS) * NS_PER_TICK;
+  barrier ();
+  tsc_hz = (end_tsc - start_tsc) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+
+  printf ("TSC clock source: %'"PRIu64" cycles/s.\n", tsc_hz);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -77,6 +131,24 @@ timer_ticks (void)
   return t;
 }
 
+/* Returns the number of nanoseconds since the OS booted.  Once
+   timer_calibrate() has run, this has the resolution of the
+   CPU's time-stamp counter; before that, it advances one timer
+   tick at a time. */
+uint64_t
+timer_now (void) 
+{
+  uint64_t delta;
+
+  if (tsc_hz == 0)
+    return (uint64_t) timer_ticks () * NS_PER_TICK;
+
+  /* Split the conversion so that DELTA * 1e9 cannot overflow. */
+  delta = rdtsc () - base_tsc;
+  return (base_ns + delta / tsc_hz * 1000000000
+          + delta % tsc_hz * 1000000000 / tsc_hz);
+}
+
 /* Returns the number of timer ticks elapsed since THEN, which
    should be a value once returned by timer_ticks(). */
 int64_t
@@ -94,7 +166,6 @@ timer_sleep (int64_t sleep_ticks)
  
   enum intr_level old_level = intr_disable ();
   thread_sleep (sleep_ticks + ticks);
-  thread_block ();
   intr_set_level (old_level);
 }
 
@@ -170,24 +241,38 @@ timer_print_stats (void)
 
 /* Timer interrupt handler. */
 static void
-timer_interrupt (struct intr_frame *args UNUSED)
+timer_interrupt (struct intr_frame *args)
 {
   ticks++;
+  profile_sample (args);
   thread_tick ();
+  workqueue_tick (ticks);
   if(thread_mlfqs) {
-      if(ticks%TIMER_FREQ == 0) {
-          // update recent_cpu and load_avg
-          thread_update_load_avg(true);
-          thread_foreach (thread_update_recent_cpu, NULL);
-      }
-      if(ticks%4 == 0) {
-          // update priority
-          thread_foreach (thread_update_priority, NULL);
-          thread_priority_sort ();
-      }
+      // recompute priorities, and once a second recent_cpu and
+      // load_avg, in the timer softirq
+      if(ticks%TIMER_FREQ == 0)
+          mlfqs_new_second = true;
+      if(ticks%4 == 0 || mlfqs_new_second)
+          softirq_raise (SOFTIRQ_TIMER);
   }
 }
 
+/* Timer softirq: does the scheduler bookkeeping that is too
+   slow to do with interrupts off in timer_interrupt(). */
+static void
+timer_softirq (void) 
+{
+  enum intr_level old_level;
+  bool new_second;
+
+  old_level = intr_disable ();
+  new_second = mlfqs_new_second;
+  mlfqs_new_second = false;
+  intr_set_level (old_level);
+
+  thread_mlfqs_update (new_second);
+}
+
 /* Returns true if LOOPS iterations waits for more than one timer
    tick, otherwise false. */
 static bool
@@ -232,21 +317,41 @@ real_time_sleep (int64_t num, int32_t denom)
      1 s / TIMER_FREQ ticks
   */
   int64_t ticks = num * TIMER_FREQ / denom;
+  uint64_t deadline;
 
   ASSERT (intr_get_level () == INTR_ON);
-  if (ticks > 0)
+  ASSERT (denom % 1000 == 0);
+  if (num <= 0)
+    return;
+
+  if (tsc_hz == 0)
     {
-      /* We're waiting for at least one full timer tick.  Use
-         timer_sleep() because it will yield the CPU to other
-         processes. */                
-      timer_sleep (ticks); 
+      /* No clock source yet.  Sleep for whole ticks, or else use
+         a busy-wait loop for sub-tick timing. */
+      if (ticks > 0)
+        timer_sleep (ticks);
+      else
+        real_time_delay (num, denom);
+      return;
     }
-  else 
+
+  /* If the sleep lasts a tick or more, sleep until the last tick
+     before the deadline, yielding the CPU to other processes,
+     then wait out the rest, less than a tick, against the clock
+     source.  There is no one-shot timer to wake us for the rest,
+     and blocking until the following tick would stretch it to a
+     whole tick, so spin instead.  Short sleeps, such as the IDE
+     driver's waits of a few microseconds, spin throughout and
+     never reach the scheduler. */
+  deadline = timer_now () + num * (1000000000 / denom);
+  if (ticks > 0)
     {
-      /* Otherwise, use a busy-wait loop for more accurate
-         sub-tick timing. */
-      real_time_delay (num, denom); 
+      enum intr_level old_level = intr_disable ();
+      thread_sleep (deadline / NS_PER_TICK);
+      intr_set_level (old_level);
     }
+  while (timer_now () < deadline)
+    barrier ();
 }
 
 /* Busy-wait for approximately NUM/DENOM seconds. */
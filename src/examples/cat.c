@@ -13,22 +13,19 @@ main (int argc, char *argv[])
   
   for (i = 1; i < argc; i++) 
     {
-      int fd = open (argv[i]);
-      if (fd < 0) 
+      FILE *file = fopen (argv[i], "r");
+      char buffer[1024];
+      size_t bytes_read;
+
+      if (file == NULL) 
         {
           printf ("%s: open failed\n", argv[i]);
           success = false;
           continue;
         }
-      for (;;) 
-        {
-          char buffer[1024];
-          int bytes_read = read (fd, buffer, sizeof buffer);
-          if (bytes_read == 0)
-            break;
-          write (STDOUT_FILENO, buffer, bytes_read);
-        }
-      close (fd);
+      while ((bytes_read = fread (buffer, 1, sizeof buffer, file)) > 0)
+        fwrite (buffer, 1, bytes_read, stdout);
+      fclose (file);
     }
   return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -8,7 +8,8 @@
 int
 main (int argc, char *argv[]) 
 {
-  int fd[2];
+  FILE *file[2];
+  int pos;
 
   if (argc != 3) 
     {
@@ -17,49 +18,41 @@ main (int argc, char *argv[])
     }
 
   /* Open files. */
-  fd[0] = open (argv[1]);
-  if (fd[0] < 0) 
+  file[0] = fopen (argv[1], "r");
+  if (file[0] == NULL) 
     {
       printf ("%s: open failed\n", argv[1]);
       return EXIT_FAILURE;
     }
-  fd[1] = open (argv[2]);
-  if (fd[1] < 0) 
+  file[1] = fopen (argv[2], "r");
+  if (file[1] == NULL) 
     {
-      printf ("%s: open failed\n", argv[1]);
+      printf ("%s: open failed\n", argv[2]);
       return EXIT_FAILURE;
     }
 
-  /* Compare data. */
-  for (;;) 
+  /* Compare data, a byte at a time. */
+  for (pos = 0; ; pos++) 
     {
-      int pos;
-      char buffer[2][1024];
-      int bytes_read[2];
-      int min_read;
-      int i;
+      int c[2];
 
-      pos = tell (fd[0]);
-      bytes_read[0] = read (fd[0], buffer[0], sizeof buffer[0]);
-      bytes_read[1] = read (fd[1], buffer[1], sizeof buffer[1]);
-      min_read = bytes_read[0] < bytes_read[1] ? bytes_read[0] : bytes_read[1];
-      if (min_read == 0)
+      c[0] = fgetc (file[0]);
+      c[1] = fgetc (file[1]);
+      if (c[0] == EOF && c[1] == EOF)
         break;
-
-      for (i = 0; i < min_read; i++)
-        if (buffer[0][i] != buffer[1][i]) 
-          {
-            printf ("Byte %d is %02hhx ('%c') in %s but %02hhx ('%c') in %s\n",
-                    pos + i,
-                    buffer[0][i], buffer[0][i], argv[1],
-                    buffer[1][i], buffer[1][i], argv[2]);
-            return EXIT_FAILURE;
-          }
-
-      if (min_read < bytes_read[1])
-        printf ("%s is shorter than %s\n", argv[1], argv[2]);
-      else if (min_read < bytes_read[0])
-        printf ("%s is shorter than %s\n", argv[2], argv[1]);
+      else if (c[0] == EOF || c[1] == EOF)
+        {
+          int shorter = c[0] == EOF ? 0 : 1;
+          printf ("%s is shorter than %s\n",
+                  argv[1 + shorter], argv[2 - shorter]);
+          return EXIT_FAILURE;
+        }
+      else if (c[0] != c[1]) 
+        {
+          printf ("Byte %d is %02x ('%c') in %s but %02x ('%c') in %s\n",
+                  pos, c[0], c[0], argv[1], c[1], c[1], argv[2]);
+          return EXIT_FAILURE;
+        }
     }
 
   printf ("%s and %s are identical\n", argv[1], argv[2]);
@@ -8,7 +8,9 @@ Copies one file to another. */
 int
 main (int argc, char *argv[]) 
 {
-  int in_fd, out_fd;
+  FILE *in, *out;
+  char buffer[1024];
+  size_t bytes_read;
 
   if (argc != 3) 
     {
@@ -17,38 +19,42 @@ main (int argc, char *argv[])
     }
 
   /* Open input file. */
-  in_fd = open (argv[1]);
-  if (in_fd < 0) 
+  in = fopen (argv[1], "r");
+  if (in == NULL) 
     {
       printf ("%s: open failed\n", argv[1]);
       return EXIT_FAILURE;
     }
 
-  /* Create and open output file. */
-  if (!create (argv[2], filesize (in_fd))) 
+  /* Create and open output file.
+     fopen() does not truncate: opening an existing NEW that is
+     longer than OLD with "w" would leave its trailing bytes in
+     place after the copy.  So NEW is always created here, with
+     exactly OLD's size, and cp fails if NEW already exists
+     rather than overwrite it. */
+  if (!create (argv[2], filesize (fileno (in)))) 
     {
       printf ("%s: create failed\n", argv[2]);
       return EXIT_FAILURE;
     }
-  out_fd = open (argv[2]);
-  if (out_fd < 0) 
+  out = fopen (argv[2], "w");
+  if (out == NULL) 
     {
       printf ("%s: open failed\n", argv[2]);
       return EXIT_FAILURE;
     }
 
   /* Copy data. */
-  for (;;) 
+  while ((bytes_read = fread (buffer, 1, sizeof buffer, in)) > 0)
+    if (fwrite (buffer, 1, bytes_read, out) != bytes_read) 
+      {
+        printf ("%s: write failed\n", argv[2]);
+        return EXIT_FAILURE;
+      }
+  if (fclose (out) == EOF)
     {
-      char buffer[1024];
-      int bytes_read = read (in_fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
-        break;
-      if (write (out_fd, buffer, bytes_read) != bytes_read) 
-        {
-          printf ("%s: write failed\n", argv[2]);
-          return EXIT_FAILURE;
-        }
+      printf ("%s: write failed\n", argv[2]);
+      return EXIT_FAILURE;
     }
 
   return EXIT_SUCCESS;
@@ -13,23 +13,23 @@ main (int argc, char *argv[])
   
   for (i = 1; i < argc; i++) 
     {
-      int fd = open (argv[i]);
-      if (fd < 0) 
+      FILE *file = fopen (argv[i], "r");
+      char buffer[1024];
+      size_t bytes_read;
+      int pos = 0;
+
+      if (file == NULL) 
         {
           printf ("%s: open failed\n", argv[i]);
           success = false;
           continue;
         }
-      for (;;) 
+      while ((bytes_read = fread (buffer, 1, sizeof buffer, file)) > 0)
         {
-          char buffer[1024];
-          int pos = tell (fd);
-          int bytes_read = read (fd, buffer, sizeof buffer);
-          if (bytes_read == 0)
-            break;
           hex_dump (pos, buffer, bytes_read, true);
+          pos += bytes_read;
         }
-      close (fd);
+      fclose (file);
     }
   return success ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,157 @@
+/* iobench.c
+
+   Copies a file one byte at a time, first with a read() and a
+   write() system call per byte, then through buffered streams
+   with fgetc() and fputc(), using the default BUFSIZ buffers and
+   then 4 kB buffers given to setvbuf().  Prints the number of
+   system calls and CPU cycles each copy takes.
+
+   usage: iobench [SIZE]
+
+   SIZE is the size of the file to copy, in bytes, by default 1
+   MB.  The file system needs room for two files of SIZE bytes,
+   e.g. "pintos --filesys-size=4". */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+#define IN_FILE "iobench.in"
+#define OUT_FILE "iobench.out"
+
+/* Returns the number of system calls made so far by this
+   process. */
+static unsigned long long
+syscall_cnt (void)
+{
+  struct syscall_stat s;
+  return stats (STATS_PROCESS, &s) ? s.cnt : 0;
+}
+
+/* Returns the CPU's time-stamp counter. */
+static unsigned long long
+rdtsc (void)
+{
+  unsigned long long tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Copies IN_FILE to OUT_FILE a byte at a time with read() and
+   write(). */
+static void
+copy_unbuffered (void)
+{
+  int in = open (IN_FILE);
+  int out = open (OUT_FILE);
+  char c;
+
+  if (in < 0 || out < 0)
+    exit (EXIT_FAILURE);
+  while (read (in, &c, 1) == 1)
+    write (out, &c, 1);
+  close (in);
+  close (out);
+}
+
+/* Copies IN_FILE to OUT_FILE a byte at a time with fgetc() and
+   fputc(), using buffers of BUF_SIZE bytes, or the default
+   buffers if BUF_SIZE is 0. */
+static void
+copy_buffered (size_t buf_size)
+{
+  static char in_buf[4096], out_buf[4096];
+  FILE *in = fopen (IN_FILE, "r");
+  FILE *out = fopen (OUT_FILE, "w");
+  int c;
+
+  if (in == NULL || out == NULL)
+    exit (EXIT_FAILURE);
+  if (buf_size > 0)
+    {
+      setvbuf (in, in_buf, _IOFBF, buf_size);
+      setvbuf (out, out_buf, _IOFBF, buf_size);
+    }
+  while ((c = fgetc (in)) != EOF)
+    fputc (c, out);
+  fclose (in);
+  fclose (out);
+}
+
+/* Returns true if IN_FILE and OUT_FILE have the same contents. */
+static bool
+same_contents (void)
+{
+  FILE *a = fopen (IN_FILE, "r");
+  FILE *b = fopen (OUT_FILE, "r");
+  bool same = a != NULL && b != NULL;
+  int c;
+
+  while (same && (c = fgetc (a)) != EOF)
+    same = fgetc (b) == c;
+  if (a != NULL)
+    fclose (a);
+  if (b != NULL)
+    fclose (b);
+  return same;
+}
+
+/* Copies the file with copy_buffered (BUF_SIZE) if BUFFERED
+   is true, otherwise with copy_unbuffered(), then prints the
+   cost as NAME and checks the copy. */
+static bool
+measure (const char *name, bool buffered, size_t buf_size)
+{
+  unsigned long long start_cnt, start_tsc, cnt, cycles;
+
+  start_cnt = syscall_cnt ();
+  start_tsc = rdtsc ();
+  if (buffered)
+    copy_buffered (buf_size);
+  else
+    copy_unbuffered ();
+  cycles = rdtsc () - start_tsc;
+
+  /* Don't count the first stats() call. */
+  cnt = syscall_cnt () - start_cnt - 1;
+
+  printf ("%-24s %10llu system calls, %14llu cycles\n", name, cnt, cycles);
+  if (!same_contents ())
+    {
+      printf ("%s: copy differs from original\n", name);
+      return false;
+    }
+  return true;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int size = argc > 1 ? atoi (argv[1]) : 1024 * 1024;
+  bool success;
+  FILE *in;
+  int i;
+
+  /* Create the input file, with bytes that are not all the same,
+     and an output file of the same size. */
+  if (size <= 0 || !create (IN_FILE, size) || !create (OUT_FILE, size))
+    {
+      printf ("iobench: cannot create %d-byte files\n", size);
+      return EXIT_FAILURE;
+    }
+  in = fopen (IN_FILE, "w");
+  if (in == NULL)
+    return EXIT_FAILURE;
+  for (i = 0; i < size; i++)
+    fputc (i * 7 + i / 251, in);
+  fclose (in);
+
+  printf ("Copying %d bytes one byte at a time:\n", size);
+  success = (measure ("read() and write()", false, 0)
+             && measure ("fgetc() and fputc()", true, 0)
+             && measure ("  with 4 kB buffers", true, 4096));
+
+  remove (IN_FILE);
+  remove (OUT_FILE);
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
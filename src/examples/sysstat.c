@@ -0,0 +1,36 @@
+/* sysstat.c
+
+   Prints statistics for each system call made so far by all
+   processes, followed by the totals for this process. */
+
+#include <stdio.h>
+#include <syscall.h>
+
+static void
+print_stat (const char *name, const struct syscall_stat *s)
+{
+  printf ("%-10s %8llu %12llu %12llu %12llu %12llu\n", name, s->cnt,
+          s->cnt ? s->cycles / s->cnt : 0, s->min_cycles, s->max_cycles,
+          s->bytes);
+}
+
+int
+main (void)
+{
+  struct syscall_stat s;
+  int i;
+
+  printf ("%-10s %8s %12s %12s %12s %12s\n",
+          "syscall", "calls", "avg cycles", "min", "max", "bytes");
+  for (i = 0; stats (i, &s); i++)
+    if (s.cnt > 0)
+      {
+        char name[16];
+        snprintf (name, sizeof name, "#%d", i);
+        print_stat (name, &s);
+      }
+
+  if (stats (STATS_PROCESS, &s))
+    print_stat ("(self)", &s);
+  return EXIT_SUCCESS;
+}
@@ -4,7 +4,7 @@
 #include <list.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
-#include "threads/malloc.h"
+#include "threads/slab.h"
 
 /* A directory. */
 struct dir 
@@ -21,6 +21,17 @@ struct dir_entry
     bool in_use;                        /* In use or free? */
   };
 
+/* Cache of struct dirs. */
+static struct kmem_cache dir_cache;
+
+/* Initializes the directory module. */
+void
+dir_init (void) 
+{
+  kmem_cache_init (&dir_cache, "dir", sizeof (struct dir),
+                   __alignof__ (struct dir), NULL);
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
    given SECTOR.  Returns true if successful, false on failure. */
 bool
@@ -34,7 +45,7 @@ dir_create (block_sector_t sector, size_t entry_cnt)
 struct dir *
 dir_open (struct inode *inode) 
 {
-  struct dir *dir = calloc (1, sizeof *dir);
+  struct dir *dir = kmem_cache_zalloc (&dir_cache);
   if (inode != NULL && dir != NULL)
     {
       dir->inode = inode;
@@ -44,7 +55,7 @@ dir_open (struct inode *inode)
   else
     {
       inode_close (inode);
-      free (dir);
+      kmem_cache_free (&dir_cache, dir);
       return NULL; 
     }
 }
@@ -72,7 +83,7 @@ dir_close (struct dir *dir)
   if (dir != NULL)
     {
       inode_close (dir->inode);
-      free (dir);
+      kmem_cache_free (&dir_cache, dir);
     }
 }
 
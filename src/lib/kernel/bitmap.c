@@ -69,6 +69,34 @@ last_mask (const struct bitmap *b)
   return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
 
+/* Returns a mask of the bits in element ELEM_IDX that represent
+   bits START through END - 1 of a bitmap, where START < END and
+   ELEM_IDX is between elem_idx(START) and elem_idx(END - 1). */
+static inline elem_type
+range_mask (size_t elem_idx, size_t start, size_t end) 
+{
+  elem_type mask = (elem_type) -1;
+
+  if (elem_idx == start / ELEM_BITS)
+    mask &= (elem_type) -1 << (start % ELEM_BITS);
+  if (elem_idx == (end - 1) / ELEM_BITS)
+    mask &= (elem_type) -1 >> (ELEM_BITS - 1 - (end - 1) % ELEM_BITS);
+  return mask;
+}
+
+/* Returns the number of 1-bits in X, by adding up the bits in
+   ever wider fields in parallel. */
+static inline size_t
+count_ones (elem_type x) 
+{
+  const elem_type ones = (elem_type) -1;
+
+  x -= (x >> 1) & (ones / 3);
+  x = (x & (ones / 15 * 3)) + ((x >> 2) & (ones / 15 * 3));
+  x = (x + (x >> 4)) & (ones / 255 * 15);
+  return (elem_type) (x * (ones / 255)) >> (sizeof x - 1) * CHAR_BIT;
+}
+
 /* Creation and destruction. */
 
 /* Initializes B to be a bitmap of BIT_CNT bits
@@ -194,6 +222,16 @@ bitmap_flip (struct bitmap *b, size_t bit_idx)
   asm ("xorl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
 }
 
+/* Atomically sets the bits in MASK in element E to VALUE. */
+static inline void
+set_elem_bits (elem_type *e, elem_type mask, bool value) 
+{
+  if (value)
+    asm ("orl %1, %0" : "+m" (*e) : "r" (mask) : "cc");
+  else
+    asm ("andl %1, %0" : "+m" (*e) : "r" (~mask) : "cc");
+}
+
 /* Returns the value of the bit numbered IDX in B. */
 bool
 bitmap_test (const struct bitmap *b, size_t idx) 
@@ -205,6 +243,26 @@ bitmap_test (const struct bitmap *b, size_t idx)
 
 /* Setting and testing multiple bits. */
 
+/* Returns the index of the first bit in B between START and END,
+   exclusive, that is set to VALUE, or END if there is none.
+   Skips over whole elements that have no such bit. */
+static size_t
+find_bit (const struct bitmap *b, size_t start, size_t end, bool value) 
+{
+  size_t i;
+
+  if (start >= end)
+    return end;
+  for (i = elem_idx (start); i <= elem_idx (end - 1); i++) 
+    {
+      elem_type e = value ? b->bits[i] : ~b->bits[i];
+      e &= range_mask (i, start, end);
+      if (e != 0)
+        return i * ELEM_BITS + __builtin_ctzl (e);
+    }
+  return end;
+}
+
 /* Sets all bits in B to VALUE. */
 void
 bitmap_set_all (struct bitmap *b, bool value) 
@@ -218,14 +276,16 @@ bitmap_set_all (struct bitmap *b, bool value)
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
+  size_t end = start + cnt;
   size_t i;
   
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  if (cnt > 0)
+    for (i = elem_idx (start); i <= elem_idx (end - 1); i++)
+      set_elem_bits (&b->bits[i], range_mask (i, start, end), value);
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -233,6 +293,7 @@ bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
+  size_t end = start + cnt;
   size_t i, value_cnt;
 
   ASSERT (b != NULL);
@@ -240,10 +301,10 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (start + cnt <= b->bit_cnt);
 
   value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      value_cnt++;
-  return value_cnt;
+  if (cnt > 0)
+    for (i = elem_idx (start); i <= elem_idx (end - 1); i++)
+      value_cnt += count_ones (b->bits[i] & range_mask (i, start, end));
+  return value ? value_cnt : cnt - value_cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -251,16 +312,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
-  
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
-  return false;
+  return find_bit (b, start, start + cnt, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -299,13 +355,28 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
+  if (cnt == 0)
+    return start;
   if (cnt <= b->bit_cnt) 
     {
       size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      size_t i = start;
+
+      /* Find a bit set to VALUE, then the first bit not set to
+         VALUE after it.  If the run between them is too short,
+         go on looking from there. */
+      for (;;)
+        {
+          size_t run_end;
+
+          i = find_bit (b, i, last + 1, value);
+          if (i > last)
+            break;
+          run_end = find_bit (b, i, i + cnt, !value);
+          if (run_end == i + cnt)
+            return i;
+          i = run_end;
+        }
     }
   return BITMAP_ERROR;
 }
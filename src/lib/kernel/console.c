@@ -1,13 +1,15 @@
 #include <console.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include "devices/serial.h"
 #include "devices/vga.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 
-static void vprintf_helper (char, void *);
+static void vprintf_helper (const char *, size_t, void *);
+static void putbuf_have_lock (const char *, size_t);
 static void putchar_have_lock (uint8_t c);
 
 /* The console lock.
@@ -63,7 +65,7 @@ static int64_t write_cnt;
 void
 console_init (void) 
 {
-  lock_init (&console_lock);
+  lock_init_named (&console_lock, "console");
   use_console_lock = true;
 }
 
@@ -87,7 +89,7 @@ console_print_stats (void)
 static void
 acquire_console (void) 
 {
-  if (!intr_context () && use_console_lock) 
+  if (!intr_context () && !softirq_context () && use_console_lock) 
     {
       if (lock_held_by_current_thread (&console_lock)) 
         console_lock_depth++; 
@@ -100,7 +102,7 @@ acquire_console (void)
 static void
 release_console (void) 
 {
-  if (!intr_context () && use_console_lock) 
+  if (!intr_context () && !softirq_context () && use_console_lock) 
     {
       if (console_lock_depth > 0)
         console_lock_depth--;
@@ -115,20 +117,22 @@ static bool
 console_locked_by_current_thread (void) 
 {
   return (intr_context ()
+          || softirq_context ()
           || !use_console_lock
           || lock_held_by_current_thread (&console_lock));
 }
 
 /* The standard vprintf() function,
    which is like printf() but uses a va_list.
-   Writes its output to both vga display and serial port. */
+   Writes its output to both vga display and serial port, a
+   buffer at a time. */
 int
 vprintf (const char *format, va_list args) 
 {
   int char_cnt = 0;
 
   acquire_console ();
-  __vprintf (format, args, vprintf_helper, &char_cnt);
+  __vprintf_bulk (format, args, vprintf_helper, &char_cnt);
   release_console ();
 
   return char_cnt;
@@ -140,8 +144,7 @@ int
 puts (const char *s) 
 {
   acquire_console ();
-  while (*s != '\0')
-    putchar_have_lock (*s++);
+  putbuf_have_lock (s, strlen (s));
   putchar_have_lock ('\n');
   release_console ();
 
@@ -153,8 +156,7 @@ void
 putbuf (const char *buffer, size_t n) 
 {
   acquire_console ();
-  while (n-- > 0)
-    putchar_have_lock (*buffer++);
+  putbuf_have_lock (buffer, n);
   release_console ();
 }
 
@@ -171,11 +173,23 @@ putchar (int c)
 
 /* Helper function for vprintf(). */
 static void
-vprintf_helper (char c, void *char_cnt_) 
+vprintf_helper (const char *buffer, size_t n, void *char_cnt_) 
 {
   int *char_cnt = char_cnt_;
-  (*char_cnt)++;
-  putchar_have_lock (c);
+  *char_cnt += n;
+  putbuf_have_lock (buffer, n);
+}
+
+/* Writes the N characters in BUFFER to the vga display and
+   serial port.  The caller has already acquired the console
+   lock if appropriate. */
+static void
+putbuf_have_lock (const char *buffer, size_t n) 
+{
+  ASSERT (console_locked_by_current_thread ());
+  write_cnt += n;
+  serial_putbuf ((const uint8_t *) buffer, n);
+  vga_putbuf (buffer, n);
 }
 
 /* Writes C to the vga display and serial port.
@@ -428,3 +428,328 @@ remove_elem (struct hash *h, struct hash_elem *e)
   list_remove (&e->list_elem);
 }
 
+
+/* Open-addressing hash table. */
+
+/* Number of slots an ohash starts with; also its minimum. */
+#define OHASH_MIN_SLOTS 16
+
+/* Number of old slots moved into the new array on each insertion
+   or deletion while an ohash is resizing.  Resizing must finish
+   before the new array fills up, which this many per operation
+   guarantees. */
+#define OHASH_MOVE_SLOTS 8
+
+/* Marks a slot in an old slot array whose element has been
+   deleted or moved.  Lookups probe past it, unlike an empty
+   slot. */
+static struct hash_elem tombstone;
+#define TOMBSTONE (&tombstone)
+
+static struct ohash_slot *probe (struct ohash *, struct ohash_slot *,
+                                 size_t slot_cnt, struct hash_elem *,
+                                 unsigned hash);
+static struct ohash_slot *ohash_lookup (struct ohash *, struct hash_elem *,
+                                        unsigned hash);
+static void ohash_put (struct ohash *, unsigned hash, struct hash_elem *);
+static void ohash_remove (struct ohash *, struct ohash_slot *);
+static void ohash_step (struct ohash *);
+static void ohash_move (struct ohash *, size_t cnt);
+
+/* Initializes open-addressing hash table H to compute hash
+   values using HASH and compare hash elements using LESS, given
+   auxiliary data AUX.  Returns true if successful, false if
+   memory allocation failed. */
+bool
+ohash_init (struct ohash *h,
+            hash_hash_func *hash, hash_less_func *less, void *aux) 
+{
+  h->elem_cnt = h->used_cnt = 0;
+  h->slot_cnt = OHASH_MIN_SLOTS;
+  h->slots = calloc (h->slot_cnt, sizeof *h->slots);
+  h->old_slots = NULL;
+  h->old_slot_cnt = h->move_idx = 0;
+  h->hash = hash;
+  h->less = less;
+  h->aux = aux;
+  return h->slots != NULL;
+}
+
+/* Removes all the elements from H, calling DESTRUCTOR, if it is
+   non-null, for each of them.  The same restrictions apply as
+   for hash_clear(). */
+void
+ohash_clear (struct ohash *h, hash_action_func *destructor) 
+{
+  size_t i;
+
+  if (destructor != NULL)
+    ohash_apply (h, destructor);
+
+  free (h->old_slots);
+  h->old_slots = NULL;
+  h->old_slot_cnt = h->move_idx = 0;
+  for (i = 0; i < h->slot_cnt; i++)
+    h->slots[i].elem = NULL;
+  h->elem_cnt = h->used_cnt = 0;
+}
+
+/* Destroys H, first calling DESTRUCTOR, if it is non-null, for
+   each element.  The same restrictions apply as for
+   hash_destroy(). */
+void
+ohash_destroy (struct ohash *h, hash_action_func *destructor) 
+{
+  if (destructor != NULL)
+    ohash_apply (h, destructor);
+  free (h->old_slots);
+  free (h->slots);
+}
+
+/* Inserts NEW into H and returns a null pointer, if no equal
+   element is already in the table.  If an equal element is
+   already in the table, returns it without inserting NEW.
+   Panics if the table is full and cannot grow. */
+struct hash_elem *
+ohash_insert (struct ohash *h, struct hash_elem *new) 
+{
+  unsigned hash = h->hash (new, h->aux);
+  struct ohash_slot *s;
+
+  ohash_step (h);
+  s = ohash_lookup (h, new, hash);
+  if (s != NULL)
+    return s->elem;
+
+  ohash_put (h, hash, new);
+  h->elem_cnt++;
+  return NULL;
+}
+
+/* Inserts NEW into H, replacing any equal element already in the
+   table, which is returned. */
+struct hash_elem *
+ohash_replace (struct ohash *h, struct hash_elem *new) 
+{
+  unsigned hash = h->hash (new, h->aux);
+  struct ohash_slot *s;
+  struct hash_elem *old;
+
+  ohash_step (h);
+  s = ohash_lookup (h, new, hash);
+  if (s == NULL)
+    {
+      ohash_put (h, hash, new);
+      h->elem_cnt++;
+      return NULL;
+    }
+
+  old = s->elem;
+  s->elem = new;
+  return old;
+}
+
+/* Finds and returns an element equal to E in H, or a null
+   pointer if no equal element exists in the table. */
+struct hash_elem *
+ohash_find (struct ohash *h, struct hash_elem *e) 
+{
+  struct ohash_slot *s = ohash_lookup (h, e, h->hash (e, h->aux));
+
+  return s != NULL ? s->elem : NULL;
+}
+
+/* Finds, removes, and returns an element equal to E in H.
+   Returns a null pointer if no equal element existed in the
+   table. */
+struct hash_elem *
+ohash_delete (struct ohash *h, struct hash_elem *e) 
+{
+  struct ohash_slot *s = ohash_lookup (h, e, h->hash (e, h->aux));
+  struct hash_elem *found;
+
+  if (s == NULL)
+    return NULL;
+
+  found = s->elem;
+  ohash_remove (h, s);
+  h->elem_cnt--;
+  ohash_step (h);
+  return found;
+}
+
+/* Calls ACTION for each element in H in arbitrary order.  The
+   same restrictions apply as for hash_apply(). */
+void
+ohash_apply (struct ohash *h, hash_action_func *action) 
+{
+  size_t i;
+
+  ASSERT (action != NULL);
+
+  for (i = 0; i < h->old_slot_cnt; i++)
+    if (h->old_slots[i].elem != NULL && h->old_slots[i].elem != TOMBSTONE)
+      action (h->old_slots[i].elem, h->aux);
+  for (i = 0; i < h->slot_cnt; i++)
+    if (h->slots[i].elem != NULL)
+      action (h->slots[i].elem, h->aux);
+}
+
+/* Returns the number of elements in H. */
+size_t
+ohash_size (struct ohash *h) 
+{
+  return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+ohash_empty (struct ohash *h) 
+{
+  return h->elem_cnt == 0;
+}
+
+/* Searches the SLOT_CNT slots in SLOTS for an element equal to E,
+   whose hash value is HASH.  Returns its slot if found or a null
+   pointer otherwise. */
+static struct ohash_slot *
+probe (struct ohash *h, struct ohash_slot *slots, size_t slot_cnt,
+       struct hash_elem *e, unsigned hash) 
+{
+  size_t i;
+
+  for (i = hash & (slot_cnt - 1); slots[i].elem != NULL;
+       i = (i + 1) & (slot_cnt - 1)) 
+    {
+      struct hash_elem *si = slots[i].elem;
+      if (si != TOMBSTONE && slots[i].hash == hash
+          && !h->less (si, e, h->aux) && !h->less (e, si, h->aux))
+        return &slots[i];
+    }
+  return NULL;
+}
+
+/* Searches H for an element equal to E, whose hash value is
+   HASH.  Returns its slot if found or a null pointer
+   otherwise. */
+static struct ohash_slot *
+ohash_lookup (struct ohash *h, struct hash_elem *e, unsigned hash) 
+{
+  struct ohash_slot *s = probe (h, h->slots, h->slot_cnt, e, hash);
+
+  if (s == NULL && h->old_slots != NULL)
+    s = probe (h, h->old_slots, h->old_slot_cnt, e, hash);
+  return s;
+}
+
+/* Puts E, whose hash value is HASH and which must not be in H,
+   into the first empty slot in H's current slot array that is at
+   or after its home slot. */
+static void
+ohash_put (struct ohash *h, unsigned hash, struct hash_elem *e) 
+{
+  size_t i;
+
+  /* Keep at least one slot empty, so that probes end. */
+  if (h->used_cnt + 1 >= h->slot_cnt)
+    PANIC ("open-addressing hash table full and out of memory");
+
+  for (i = hash & (h->slot_cnt - 1); h->slots[i].elem != NULL;
+       i = (i + 1) & (h->slot_cnt - 1))
+    continue;
+  h->slots[i].hash = hash;
+  h->slots[i].elem = e;
+  h->used_cnt++;
+}
+
+/* Empties slot S in H. */
+static void
+ohash_remove (struct ohash *h, struct ohash_slot *s) 
+{
+  size_t mask = h->slot_cnt - 1;
+  size_t i, j;
+
+  if (s < h->slots || s >= h->slots + h->slot_cnt)
+    {
+      /* Old slots are never probed for a place to insert, so a
+         tombstone is all it takes. */
+      s->elem = TOMBSTONE;
+      return;
+    }
+
+  /* Move back each element after the hole that would no longer
+     be found from its home slot, so that no tombstones are
+     needed. */
+  i = s - h->slots;
+  for (j = (i + 1) & mask; h->slots[j].elem != NULL; j = (j + 1) & mask) 
+    {
+      size_t home = h->slots[j].hash & mask;
+      if (((j - home) & mask) >= ((j - i) & mask))
+        {
+          h->slots[i] = h->slots[j];
+          i = j;
+        }
+    }
+  h->slots[i].elem = NULL;
+  h->used_cnt--;
+}
+
+/* Does a little resizing work for H: moves a few slots if it is
+   resizing, otherwise starts to resize if the current slot
+   array is more than half full or less than an eighth full.  If
+   memory allocation fails, H keeps using its current array. */
+static void
+ohash_step (struct ohash *h) 
+{
+  struct ohash_slot *new_slots;
+  size_t new_slot_cnt;
+
+  if (h->old_slots != NULL)
+    {
+      ohash_move (h, OHASH_MOVE_SLOTS);
+      return;
+    }
+
+  if (h->used_cnt * 2 > h->slot_cnt)
+    new_slot_cnt = h->slot_cnt * 2;
+  else if (h->used_cnt * 8 < h->slot_cnt && h->slot_cnt > OHASH_MIN_SLOTS)
+    new_slot_cnt = h->slot_cnt / 2;
+  else
+    return;
+
+  new_slots = calloc (new_slot_cnt, sizeof *new_slots);
+  if (new_slots == NULL)
+    return;
+
+  h->old_slots = h->slots;
+  h->old_slot_cnt = h->slot_cnt;
+  h->move_idx = 0;
+  h->slots = new_slots;
+  h->slot_cnt = new_slot_cnt;
+  h->used_cnt = 0;
+  ohash_move (h, OHASH_MOVE_SLOTS);
+}
+
+/* Moves the elements in the next CNT old slots in H into its
+   current slot array, leaving tombstones behind.  Frees the old
+   slot array once all of its slots have moved. */
+static void
+ohash_move (struct ohash *h, size_t cnt) 
+{
+  for (; cnt > 0 && h->move_idx < h->old_slot_cnt; cnt--) 
+    {
+      struct ohash_slot *s = &h->old_slots[h->move_idx++];
+      if (s->elem != NULL && s->elem != TOMBSTONE) 
+        {
+          ohash_put (h, s->hash, s->elem);
+          s->elem = TOMBSTONE;
+        }
+    }
+
+  if (h->move_idx >= h->old_slot_cnt)
+    {
+      free (h->old_slots);
+      h->old_slots = NULL;
+      h->old_slot_cnt = h->move_idx = 0;
+    }
+}
@@ -95,6 +95,55 @@ struct hash_elem *hash_cur (struct hash_iterator *);
 size_t hash_size (struct hash *);
 bool hash_empty (struct hash *);
 
+/* Open-addressing hash table.
+
+   An alternative to struct hash for tables that are large or
+   often searched.  It takes the same struct hash_elem elements
+   (though it does not use their list_elem) and the same hash and
+   comparison functions, but keeps the elements' hash values and
+   pointers in a flat array of slots searched by linear probing,
+   so a lookup usually touches one cache line before it compares
+   any element.
+
+   The table grows or shrinks by half by allocating a new slot
+   array and moving a few slots from the old array into it on
+   each insertion or deletion, instead of all of them at once.
+   Until all have moved, lookups search both arrays. */
+
+/* Slot in an open-addressing hash table. */
+struct ohash_slot
+  {
+    unsigned hash;              /* Hash value of ELEM. */
+    struct hash_elem *elem;     /* Element, or null if the slot is empty. */
+  };
+
+/* Open-addressing hash table. */
+struct ohash
+  {
+    size_t elem_cnt;            /* Number of elements in table. */
+    size_t used_cnt;            /* Number of elements in SLOTS. */
+    size_t slot_cnt;            /* Number of slots, a power of 2. */
+    struct ohash_slot *slots;   /* Array of `slot_cnt' slots. */
+    struct ohash_slot *old_slots; /* Slots being moved into SLOTS, or null. */
+    size_t old_slot_cnt;        /* Number of slots in OLD_SLOTS. */
+    size_t move_idx;            /* Next slot in OLD_SLOTS to move. */
+    hash_hash_func *hash;       /* Hash function. */
+    hash_less_func *less;       /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `hash' and `less'. */
+  };
+
+bool ohash_init (struct ohash *, hash_hash_func *, hash_less_func *,
+                 void *aux);
+void ohash_clear (struct ohash *, hash_action_func *);
+void ohash_destroy (struct ohash *, hash_action_func *);
+struct hash_elem *ohash_insert (struct ohash *, struct hash_elem *);
+struct hash_elem *ohash_replace (struct ohash *, struct hash_elem *);
+struct hash_elem *ohash_find (struct ohash *, struct hash_elem *);
+struct hash_elem *ohash_delete (struct ohash *, struct hash_elem *);
+void ohash_apply (struct ohash *, hash_action_func *);
+size_t ohash_size (struct ohash *);
+bool ohash_empty (struct ohash *);
+
 /* Sample hash functions. */
 unsigned hash_bytes (const void *, size_t);
 unsigned hash_string (const char *);
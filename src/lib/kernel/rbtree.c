@@ -0,0 +1,464 @@
+#include "rbtree.h"
+#include "../debug.h"
+
+/* Our red-black tree follows the algorithms in [CLRS] chapter
+   13, except that null pointers stand in for the black leaves,
+   so removal tracks the parent of the node that replaces the
+   removed one separately.  The tree's invariants are:
+
+     - The root is black.
+
+     - A red element has no red children.
+
+     - Every path from an element down to a null child passes
+       through the same number of black elements.
+
+   Together these keep the tree's height within 2 log2(n + 1). */
+
+static void update_path (struct rbtree *, struct rb_elem *);
+static void replace_child (struct rbtree *, struct rb_elem *old,
+                           struct rb_elem *new);
+static void rotate_left (struct rbtree *, struct rb_elem *);
+static void rotate_right (struct rbtree *, struct rb_elem *);
+static void insert_fixup (struct rbtree *, struct rb_elem *);
+static void remove_fixup (struct rbtree *, struct rb_elem *,
+                          struct rb_elem *parent);
+
+/* Returns true if E is a red element, false if it is black or
+   null. */
+static inline bool
+is_red (const struct rb_elem *e)
+{
+  return e != NULL && e->red;
+}
+
+/* Initializes TREE as an empty tree whose elements are ordered
+   by LESS, given auxiliary data AUX.  If UPDATE is nonnull, it
+   is called as described at the top of rbtree.h. */
+void
+rb_init (struct rbtree *tree, rb_less_func *less, rb_update_func *update,
+         void *aux)
+{
+  ASSERT (tree != NULL);
+  ASSERT (less != NULL);
+
+  tree->root = NULL;
+  tree->elem_cnt = 0;
+  tree->less = less;
+  tree->update = update;
+  tree->aux = aux;
+}
+
+/* Inserts E into TREE, after any elements equal to it. */
+void
+rb_insert (struct rbtree *tree, struct rb_elem *e)
+{
+  struct rb_elem *parent = NULL;
+  struct rb_elem **link = &tree->root;
+
+  ASSERT (tree != NULL);
+  ASSERT (e != NULL);
+
+  while (*link != NULL)
+    {
+      parent = *link;
+      if (tree->less (e, parent, tree->aux))
+        link = &parent->left;
+      else
+        link = &parent->right;
+    }
+
+  e->parent = parent;
+  e->left = e->right = NULL;
+  e->red = true;
+  *link = e;
+  tree->elem_cnt++;
+
+  update_path (tree, e);
+  insert_fixup (tree, e);
+}
+
+/* Removes E, which must be in TREE, from TREE. */
+void
+rb_remove (struct rbtree *tree, struct rb_elem *e)
+{
+  struct rb_elem *child, *parent;
+  bool removed_red;
+
+  ASSERT (tree != NULL);
+  ASSERT (e != NULL);
+  ASSERT (tree->elem_cnt > 0);
+
+  if (e->left == NULL || e->right == NULL)
+    {
+      /* E has at most one child, which takes its place. */
+      child = e->left != NULL ? e->left : e->right;
+      parent = e->parent;
+      removed_red = e->red;
+      replace_child (tree, e, child);
+    }
+  else
+    {
+      /* E's successor, which has no left child, takes its place,
+         and the successor's right child takes the successor's. */
+      struct rb_elem *next = e->right;
+      while (next->left != NULL)
+        next = next->left;
+
+      child = next->right;
+      removed_red = next->red;
+      if (next->parent == e)
+        parent = next;
+      else
+        {
+          parent = next->parent;
+          replace_child (tree, next, child);
+          next->right = e->right;
+          next->right->parent = next;
+        }
+      replace_child (tree, e, next);
+      next->left = e->left;
+      next->left->parent = next;
+      next->red = e->red;
+    }
+  tree->elem_cnt--;
+
+  update_path (tree, parent);
+  if (!removed_red)
+    remove_fixup (tree, child, parent);
+}
+
+/* Returns the root of TREE, or a null pointer if TREE is
+   empty. */
+struct rb_elem *
+rb_root (const struct rbtree *tree)
+{
+  return tree->root;
+}
+
+/* Returns the least element in TREE, or a null pointer if TREE
+   is empty. */
+struct rb_elem *
+rb_min (const struct rbtree *tree)
+{
+  struct rb_elem *e = tree->root;
+
+  if (e != NULL)
+    while (e->left != NULL)
+      e = e->left;
+  return e;
+}
+
+/* Returns the greatest element in TREE, or a null pointer if
+   TREE is empty. */
+struct rb_elem *
+rb_max (const struct rbtree *tree)
+{
+  struct rb_elem *e = tree->root;
+
+  if (e != NULL)
+    while (e->right != NULL)
+      e = e->right;
+  return e;
+}
+
+/* Returns the element after E in its tree, or a null pointer if
+   E is the greatest element. */
+struct rb_elem *
+rb_next (struct rb_elem *e)
+{
+  ASSERT (e != NULL);
+
+  if (e->right != NULL)
+    {
+      e = e->right;
+      while (e->left != NULL)
+        e = e->left;
+      return e;
+    }
+  while (e->parent != NULL && e == e->parent->right)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Returns the element before E in its tree, or a null pointer if
+   E is the least element. */
+struct rb_elem *
+rb_prev (struct rb_elem *e)
+{
+  ASSERT (e != NULL);
+
+  if (e->left != NULL)
+    {
+      e = e->left;
+      while (e->right != NULL)
+        e = e->right;
+      return e;
+    }
+  while (e->parent != NULL && e == e->parent->left)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Returns the first element in TREE equal to KEY, or a null
+   pointer if there is none.  KEY need not be in TREE. */
+struct rb_elem *
+rb_find (const struct rbtree *tree, const struct rb_elem *key)
+{
+  struct rb_elem *e = rb_lower_bound (tree, key);
+
+  return e != NULL && !tree->less (key, e, tree->aux) ? e : NULL;
+}
+
+/* Returns the first element in TREE that is not less than KEY,
+   or a null pointer if there is none.  KEY need not be in
+   TREE. */
+struct rb_elem *
+rb_lower_bound (const struct rbtree *tree, const struct rb_elem *key)
+{
+  struct rb_elem *e = tree->root;
+  struct rb_elem *bound = NULL;
+
+  while (e != NULL)
+    if (!tree->less (e, key, tree->aux))
+      {
+        bound = e;
+        e = e->left;
+      }
+    else
+      e = e->right;
+  return bound;
+}
+
+/* Returns the first element in TREE that is greater than KEY,
+   or a null pointer if there is none.  KEY need not be in
+   TREE. */
+struct rb_elem *
+rb_upper_bound (const struct rbtree *tree, const struct rb_elem *key)
+{
+  struct rb_elem *e = tree->root;
+  struct rb_elem *bound = NULL;
+
+  while (e != NULL)
+    if (tree->less (key, e, tree->aux))
+      {
+        bound = e;
+        e = e->left;
+      }
+    else
+      e = e->right;
+  return bound;
+}
+
+/* Returns the number of elements in TREE. */
+size_t
+rb_size (const struct rbtree *tree)
+{
+  return tree->elem_cnt;
+}
+
+/* Returns true if TREE is empty, false otherwise. */
+bool
+rb_empty (const struct rbtree *tree)
+{
+  return tree->elem_cnt == 0;
+}
+
+/* Calls TREE's update function on E and each of its ancestors,
+   from the bottom up. */
+static void
+update_path (struct rbtree *tree, struct rb_elem *e)
+{
+  if (tree->update != NULL)
+    for (; e != NULL; e = e->parent)
+      tree->update (e, tree->aux);
+}
+
+/* Puts NEW, which may be null, in OLD's place as a child of OLD's
+   parent, or as the root of TREE. */
+static void
+replace_child (struct rbtree *tree, struct rb_elem *old,
+               struct rb_elem *new)
+{
+  struct rb_elem *parent = old->parent;
+
+  if (new != NULL)
+    new->parent = parent;
+  if (parent == NULL)
+    tree->root = new;
+  else if (old == parent->left)
+    parent->left = new;
+  else
+    parent->right = new;
+}
+
+/* Rotates E's right child up into E's place in TREE, making E
+   its left child. */
+static void
+rotate_left (struct rbtree *tree, struct rb_elem *e)
+{
+  struct rb_elem *r = e->right;
+
+  e->right = r->left;
+  if (r->left != NULL)
+    r->left->parent = e;
+  replace_child (tree, e, r);
+  r->left = e;
+  e->parent = r;
+
+  if (tree->update != NULL)
+    {
+      tree->update (e, tree->aux);
+      tree->update (r, tree->aux);
+    }
+}
+
+/* Rotates E's left child up into E's place in TREE, making E its
+   right child. */
+static void
+rotate_right (struct rbtree *tree, struct rb_elem *e)
+{
+  struct rb_elem *l = e->left;
+
+  e->left = l->right;
+  if (l->right != NULL)
+    l->right->parent = e;
+  replace_child (tree, e, l);
+  l->right = e;
+  e->parent = l;
+
+  if (tree->update != NULL)
+    {
+      tree->update (e, tree->aux);
+      tree->update (l, tree->aux);
+    }
+}
+
+/* Restores TREE's invariants after inserting red element E. */
+static void
+insert_fixup (struct rbtree *tree, struct rb_elem *e)
+{
+  struct rb_elem *parent;
+
+  while (is_red (parent = e->parent))
+    {
+      /* PARENT is red, so it is not the root. */
+      struct rb_elem *grandparent = parent->parent;
+
+      if (parent == grandparent->left)
+        {
+          struct rb_elem *uncle = grandparent->right;
+          if (is_red (uncle))
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+              continue;
+            }
+          if (e == parent->right)
+            {
+              rotate_left (tree, parent);
+              e = parent;
+              parent = e->parent;
+            }
+          parent->red = false;
+          grandparent->red = true;
+          rotate_right (tree, grandparent);
+        }
+      else
+        {
+          struct rb_elem *uncle = grandparent->left;
+          if (is_red (uncle))
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              e = grandparent;
+              continue;
+            }
+          if (e == parent->left)
+            {
+              rotate_right (tree, parent);
+              e = parent;
+              parent = e->parent;
+            }
+          parent->red = false;
+          grandparent->red = true;
+          rotate_left (tree, grandparent);
+        }
+    }
+  tree->root->red = false;
+}
+
+/* Restores TREE's invariants after removing a black element
+   whose place was taken by E, which may be null, a child of
+   PARENT. */
+static void
+remove_fixup (struct rbtree *tree, struct rb_elem *e, struct rb_elem *parent)
+{
+  while (e != tree->root && !is_red (e))
+    {
+      /* The path through E is one black element short, so E's
+         sibling is not null. */
+      if (e == parent->left)
+        {
+          struct rb_elem *sibling = parent->right;
+          if (sibling->red)
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_left (tree, parent);
+              sibling = parent->right;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              e = parent;
+              parent = e->parent;
+              continue;
+            }
+          if (!is_red (sibling->right))
+            {
+              sibling->left->red = false;
+              sibling->red = true;
+              rotate_right (tree, sibling);
+              sibling = parent->right;
+            }
+          sibling->red = parent->red;
+          parent->red = false;
+          sibling->right->red = false;
+          rotate_left (tree, parent);
+        }
+      else
+        {
+          struct rb_elem *sibling = parent->left;
+          if (sibling->red)
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_right (tree, parent);
+              sibling = parent->left;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              e = parent;
+              parent = e->parent;
+              continue;
+            }
+          if (!is_red (sibling->left))
+            {
+              sibling->right->red = false;
+              sibling->red = true;
+              rotate_left (tree, sibling);
+              sibling = parent->left;
+            }
+          sibling->red = parent->red;
+          parent->red = false;
+          sibling->left->red = false;
+          rotate_right (tree, parent);
+        }
+      e = tree->root;
+    }
+  if (e != NULL)
+    e->red = false;
+}
@@ -0,0 +1,121 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+
+   An ordered set (or multiset) with O(log n) insertion, removal,
+   and search, for structures that would otherwise be kept in a
+   sorted list.  Like lists, trees do not use dynamic allocation:
+   each structure that can be in a tree embeds a struct rb_elem
+   member, and rb_entry converts a struct rb_elem back to the
+   structure that contains it.
+
+   For example, a tree of `struct region' ordered by start
+   address:
+
+      struct region
+        {
+          struct rb_elem elem;
+          uintptr_t start, end;
+        };
+
+      static bool
+      region_less (const struct rb_elem *a, const struct rb_elem *b,
+                   void *aux UNUSED)
+      {
+        return (rb_entry (a, struct region, elem)->start
+                < rb_entry (b, struct region, elem)->start);
+      }
+
+      struct rbtree regions;
+      struct rb_elem *e;
+
+      rb_init (&regions, region_less, NULL, NULL);
+      ...
+      for (e = rb_min (&regions); e != NULL; e = rb_next (e))
+        {
+          struct region *r = rb_entry (e, struct region, elem);
+          ...do something with r...
+        }
+
+   Elements that compare equal are kept in the order they were
+   inserted.
+
+   Augmented trees: if an UPDATE function is given to rb_init(),
+   it is called on every element whose subtree (the element
+   itself and its descendants) changes, after its children have
+   been updated.  It can keep data summarizing each subtree in
+   the element, such as the largest END of any region below it,
+   which lets a search skip subtrees that cannot contain a
+   region overlapping a given address, using the LEFT and RIGHT
+   members of struct rb_elem to walk the tree from rb_root(). */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tree element. */
+struct rb_elem
+  {
+    struct rb_elem *parent;     /* Parent, or null for the root. */
+    struct rb_elem *left;       /* Left child, or null. */
+    struct rb_elem *right;      /* Right child, or null. */
+    bool red;                   /* Red or black? */
+  };
+
+/* Converts pointer to tree element RB_ELEM into a pointer to the
+   structure that RB_ELEM is embedded inside.  Supply the name of
+   the outer structure STRUCT and the member name MEMBER of the
+   tree element. */
+#define rb_entry(RB_ELEM, STRUCT, MEMBER)               \
+        ((STRUCT *) ((uint8_t *) &(RB_ELEM)->parent     \
+                     - offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two tree elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool rb_less_func (const struct rb_elem *a,
+                           const struct rb_elem *b,
+                           void *aux);
+
+/* Recomputes the data that tree element E keeps about its
+   subtree from E itself and its children, given auxiliary data
+   AUX. */
+typedef void rb_update_func (struct rb_elem *e, void *aux);
+
+/* Red-black tree. */
+struct rbtree
+  {
+    struct rb_elem *root;       /* Root, or null if empty. */
+    size_t elem_cnt;            /* Number of elements. */
+    rb_less_func *less;         /* Comparison function. */
+    rb_update_func *update;     /* Augmentation function, or null. */
+    void *aux;                  /* Auxiliary data for LESS and UPDATE. */
+  };
+
+/* Tree initialization. */
+void rb_init (struct rbtree *, rb_less_func *, rb_update_func *, void *aux);
+
+/* Insertion and removal. */
+void rb_insert (struct rbtree *, struct rb_elem *);
+void rb_remove (struct rbtree *, struct rb_elem *);
+
+/* Traversal. */
+struct rb_elem *rb_root (const struct rbtree *);
+struct rb_elem *rb_min (const struct rbtree *);
+struct rb_elem *rb_max (const struct rbtree *);
+struct rb_elem *rb_next (struct rb_elem *);
+struct rb_elem *rb_prev (struct rb_elem *);
+
+/* Search. */
+struct rb_elem *rb_find (const struct rbtree *, const struct rb_elem *);
+struct rb_elem *rb_lower_bound (const struct rbtree *,
+                                const struct rb_elem *);
+struct rb_elem *rb_upper_bound (const struct rbtree *,
+                                const struct rb_elem *);
+
+/* Properties. */
+size_t rb_size (const struct rbtree *);
+bool rb_empty (const struct rbtree *);
+
+#endif /* lib/kernel/rbtree.h */
@@ -13,7 +13,7 @@ struct vsnprintf_aux
     int max_length;     /* Max length of output string. */
   };
 
-static void vsnprintf_helper (char, void *);
+static void vsnprintf_helper (const char *, size_t, void *);
 
 /* Like vprintf(), except that output is stored into BUFFER,
    which must have space for BUF_SIZE characters.  Writes at most
@@ -32,7 +32,7 @@ vsnprintf (char *buffer, size_t buf_size, const char *format, va_list args)
   aux.max_length = buf_size > 0 ? buf_size - 1 : 0;
 
   /* Do most of the work. */
-  __vprintf (format, args, vsnprintf_helper, &aux);
+  __vprintf_bulk (format, args, vsnprintf_helper, &aux);
 
   /* Add null terminator. */
   if (buf_size > 0)
@@ -43,12 +43,19 @@ vsnprintf (char *buffer, size_t buf_size, const char *format, va_list args)
 
 /* Helper function for vsnprintf(). */
 static void
-vsnprintf_helper (char ch, void *aux_)
+vsnprintf_helper (const char *buffer, size_t n, void *aux_)
 {
   struct vsnprintf_aux *aux = aux_;
 
-  if (aux->length++ < aux->max_length)
-    *aux->p++ = ch;
+  if (aux->length < aux->max_length)
+    {
+      size_t copy_cnt = aux->max_length - aux->length;
+      if (copy_cnt > n)
+        copy_cnt = n;
+      memcpy (aux->p, buffer, copy_cnt);
+      aux->p += copy_cnt;
+    }
+  aux->length += n;
 }
 
 /* Like printf(), except that output is stored into BUFFER,
@@ -140,31 +147,100 @@ static const struct integer_base base_o = {8, "01234567", 0, 3};
 static const struct integer_base base_x = {16, "0123456789abcdef", 'x', 4};
 static const struct integer_base base_X = {16, "0123456789ABCDEF", 'X', 4};
 
+/* Pairs of decimal digits "00" through "99", for converting
+   integers to decimal two digits at a time. */
+static const char decimal_pairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233"
+  "34353637383940414243444546474849505152535455565758596061626364656667"
+  "6869707172737475767778798081828384858687888990919293949596979899";
+
+/* Formatted output in progress.
+   Output accumulates in BUF, on the stack of the caller of
+   __vprintf_bulk(), and goes to WRITE a buffer at a time, so
+   that the console or a system call is visited once per chunk
+   instead of once per character. */
+struct printf_output 
+  {
+    char buf[128];              /* Output not yet written. */
+    size_t len;                 /* Number of bytes in BUF. */
+    void (*write) (const char *, size_t, void *); /* Bulk sink. */
+    void *aux;                  /* Auxiliary data for WRITE. */
+  };
+
+/* Auxiliary data for output_helper(). */
+struct output_aux 
+  {
+    void (*output) (char, void *); /* Per-character sink. */
+    void *aux;                  /* Auxiliary data for OUTPUT. */
+  };
+
+static void format_output (const char *format, va_list args,
+                           struct printf_output *);
+static void output_printf (struct printf_output *, const char *format, ...);
 static const char *parse_conversion (const char *format,
                                      struct printf_conversion *,
                                      va_list *);
 static void format_integer (uintmax_t value, bool is_signed, bool negative, 
                             const struct integer_base *,
                             const struct printf_conversion *,
-                            void (*output) (char, void *), void *aux);
-static void output_dup (char ch, size_t cnt,
-                        void (*output) (char, void *), void *aux);
+                            struct printf_output *);
+static char *format_digits (uintmax_t value, const struct integer_base *,
+                            char *end);
+static char *format_decimal (uint32_t value, int min_digits, char *end);
 static void format_string (const char *string, int length,
                            struct printf_conversion *,
-                           void (*output) (char, void *), void *aux);
+                           struct printf_output *);
+static void output_char (struct printf_output *, char);
+static void output_chars (struct printf_output *, const char *, size_t);
+static void output_dup (struct printf_output *, char ch, size_t cnt);
+static void output_flush (struct printf_output *);
+static void output_helper (const char *, size_t, void *);
+
+/* Formats the printf() format specification FORMAT with
+   arguments given in ARGS, passing the output to WRITE with
+   auxiliary data AUX in chunks of up to a few hundred bytes. */
+void
+__vprintf_bulk (const char *format, va_list args,
+                void (*write) (const char *, size_t, void *), void *aux)
+{
+  struct printf_output out;
 
+  out.len = 0;
+  out.write = write;
+  out.aux = aux;
+  format_output (format, args, &out);
+  output_flush (&out);
+}
+
+/* Like __vprintf_bulk(), but passes the output to OUTPUT with
+   auxiliary data AUX one character at a time. */
 void
 __vprintf (const char *format, va_list args,
            void (*output) (char, void *), void *aux)
+{
+  struct output_aux output_aux;
+
+  output_aux.output = output;
+  output_aux.aux = aux;
+  __vprintf_bulk (format, args, output_helper, &output_aux);
+}
+
+/* Formats FORMAT with arguments ARGS into OUT. */
+static void
+format_output (const char *format, va_list args, struct printf_output *out)
 {
   for (; *format != '\0'; format++)
     {
       struct printf_conversion c;
 
-      /* Literally copy non-conversions to output. */
+      /* Literally copy non-conversions to output, a run at a
+         time. */
       if (*format != '%') 
         {
-          output (*format, aux);
+          const char *start = format;
+          while (format[1] != '\0' && format[1] != '%')
+            format++;
+          output_chars (out, start, format - start + 1);
           continue;
         }
       format++;
@@ -172,7 +248,7 @@ __vprintf (const char *format, va_list args,
       /* %% => %. */
       if (*format == '%') 
         {
-          output ('%', aux);
+          output_char (out, '%');
           continue;
         }
 
@@ -220,8 +296,9 @@ __vprintf (const char *format, va_list args,
                 NOT_REACHED ();
               }
 
-            format_integer (value < 0 ? -value : value,
-                            true, value < 0, &base_d, &c, output, aux);
+            format_integer ((value < 0 ? -(uintmax_t) value
+                             : (uintmax_t) value),
+                            true, value < 0, &base_d, &c, out);
           }
           break;
           
@@ -276,7 +353,7 @@ __vprintf (const char *format, va_list args,
               default: NOT_REACHED ();
               }
 
-            format_integer (value, false, false, b, &c, output, aux);
+            format_integer (value, false, false, b, &c, out);
           }
           break;
 
@@ -284,7 +361,7 @@ __vprintf (const char *format, va_list args,
           {
             /* Treat character as single-character string. */
             char ch = va_arg (args, int);
-            format_string (&ch, 1, &c, output, aux);
+            format_string (&ch, 1, &c, out);
           }
           break;
 
@@ -298,7 +375,7 @@ __vprintf (const char *format, va_list args,
             /* Limit string length according to precision.
                Note: if c.precision == -1 then strnlen() will get
                SIZE_MAX for MAXLEN, which is just what we want. */
-            format_string (s, strnlen (s, c.precision), &c, output, aux);
+            format_string (s, strnlen (s, c.precision), &c, out);
           }
           break;
           
@@ -310,7 +387,7 @@ __vprintf (const char *format, va_list args,
 
             c.flags = POUND;
             format_integer ((uintptr_t) p, false, false,
-                            &base_x, &c, output, aux);
+                            &base_x, &c, out);
           }
           break;
       
@@ -322,16 +399,28 @@ __vprintf (const char *format, va_list args,
         case 'n':
           /* We don't support floating-point arithmetic,
              and %n can be part of a security hole. */
-          __printf ("<<no %%%c in kernel>>", output, aux, *format);
+          output_printf (out, "<<no %%%c in kernel>>", *format);
           break;
 
         default:
-          __printf ("<<no %%%c conversion>>", output, aux, *format);
+          output_printf (out, "<<no %%%c conversion>>", *format);
           break;
         }
     }
 }
 
+/* Wrapper for format_output() that converts varargs into a
+   va_list. */
+static void
+output_printf (struct printf_output *out, const char *format, ...) 
+{
+  va_list args;
+
+  va_start (args, format);
+  format_output (format, args, out);
+  va_end (args);
+}
+
 /* Parses conversion option characters starting at FORMAT and
    initializes C appropriately.  Returns the character in FORMAT
    that indicates the conversion (e.g. the `d' in `%d').  Uses
@@ -459,25 +548,23 @@ parse_conversion (const char *format, struct printf_conversion *c,
   return format;
 }
 
-/* Performs an integer conversion, writing output to OUTPUT with
-   auxiliary data AUX.  The integer converted has absolute value
-   VALUE.  If IS_SIGNED is true, does a signed conversion with
-   NEGATIVE indicating a negative value; otherwise does an
-   unsigned conversion and ignores NEGATIVE.  The output is done
-   according to the provided base B.  Details of the conversion
-   are in C. */
+/* Performs an integer conversion, writing output to OUT.  The
+   integer converted has absolute value VALUE.  If IS_SIGNED is
+   true, does a signed conversion with NEGATIVE indicating a
+   negative value; otherwise does an unsigned conversion and
+   ignores NEGATIVE.  The output is done according to the
+   provided base B.  Details of the conversion are in C. */
 static void
 format_integer (uintmax_t value, bool is_signed, bool negative, 
                 const struct integer_base *b,
                 const struct printf_conversion *c,
-                void (*output) (char, void *), void *aux)
+                struct printf_output *out)
 {
-  char buf[64], *cp;            /* Buffer and current position. */
+  char buf[64], *cp, *end;      /* Buffer, current position, end. */
   int x;                        /* `x' character to use or 0 if none. */
   int sign;                     /* Sign character or 0 if none. */
   int precision;                /* Rendered precision. */
   int pad_cnt;                  /* # of pad characters to fill field width. */
-  int digit_cnt;                /* # of digits output so far. */
 
   /* Determine sign character, if any.
      An unsigned conversion will never have a sign character,
@@ -498,77 +585,208 @@ format_integer (uintmax_t value, bool is_signed, bool negative,
      nonzero value with the # flag. */
   x = (c->flags & POUND) && value ? b->x : 0;
 
-  /* Accumulate digits into buffer.
-     This algorithm produces digits in reverse order, so later we
-     will output the buffer's content in reverse. */
-  cp = buf;
-  digit_cnt = 0;
-  while (value > 0) 
+  /* Convert the digits into the end of the buffer, working
+     backward from the least significant digit.  With the ' flag,
+     convert them elsewhere first and then copy them in with
+     commas between groups. */
+  end = buf + sizeof buf;
+  if ((c->flags & GROUP) == 0)
+    cp = format_digits (value, b, end);
+  else
     {
-      if ((c->flags & GROUP) && digit_cnt > 0 && digit_cnt % b->group == 0)
-        *cp++ = ',';
-      *cp++ = b->digits[value % b->base];
-      value /= b->base;
-      digit_cnt++;
+      char digits[24];
+      const char *dp = digits + sizeof digits;
+      const char *first = format_digits (value, b, digits + sizeof digits);
+      int digit_cnt = 0;
+
+      cp = end;
+      while (dp > first)
+        {
+          if (digit_cnt > 0 && digit_cnt % b->group == 0)
+            *--cp = ',';
+          *--cp = *--dp;
+          digit_cnt++;
+        }
     }
 
-  /* Append enough zeros to match precision.
+  /* Prepend enough zeros to match precision.
      If requested precision is 0, then a value of zero is
      rendered as a null string, otherwise as "0".
      If the # flag is used with base 8, the result must always
      begin with a zero. */
   precision = c->precision < 0 ? 1 : c->precision;
-  while (cp - buf < precision && cp < buf + sizeof buf - 1)
-    *cp++ = '0';
-  if ((c->flags & POUND) && b->base == 8 && (cp == buf || cp[-1] != '0'))
-    *cp++ = '0';
+  while (end - cp < precision && cp > buf + 1)
+    *--cp = '0';
+  if ((c->flags & POUND) && b->base == 8 && (cp == end || *cp != '0'))
+    *--cp = '0';
 
   /* Calculate number of pad characters to fill field width. */
-  pad_cnt = c->width - (cp - buf) - (x ? 2 : 0) - (sign != 0);
+  pad_cnt = c->width - (end - cp) - (x ? 2 : 0) - (sign != 0);
   if (pad_cnt < 0)
     pad_cnt = 0;
 
   /* Do output. */
   if ((c->flags & (MINUS | ZERO)) == 0)
-    output_dup (' ', pad_cnt, output, aux);
+    output_dup (out, ' ', pad_cnt);
   if (sign)
-    output (sign, aux);
+    output_char (out, sign);
   if (x) 
     {
-      output ('0', aux);
-      output (x, aux); 
+      output_char (out, '0');
+      output_char (out, x); 
     }
   if (c->flags & ZERO)
-    output_dup ('0', pad_cnt, output, aux);
-  while (cp > buf)
-    output (*--cp, aux);
+    output_dup (out, '0', pad_cnt);
+  output_chars (out, cp, end - cp);
   if (c->flags & MINUS)
-    output_dup (' ', pad_cnt, output, aux);
+    output_dup (out, ' ', pad_cnt);
 }
 
-/* Writes CH to OUTPUT with auxiliary data AUX, CNT times. */
-static void
-output_dup (char ch, size_t cnt, void (*output) (char, void *), void *aux) 
+/* Writes the digits of VALUE in base B into the bytes just
+   before END and returns the first of them.  A VALUE of 0 has
+   no digits.
+
+   Octal and hexadecimal digits come from shifts and masks.
+   Decimal digits come two at a time from decimal_pairs[], and
+   only 32-bit arithmetic is used for them, so that the compiler
+   can divide by 100 with a multiplication by its reciprocal.
+   Values wider than 32 bits need one 64-bit division for every
+   9 digits. */
+static char *
+format_digits (uintmax_t value, const struct integer_base *b, char *end)
 {
-  while (cnt-- > 0)
-    output (ch, aux);
+  char *cp = end;
+
+  if (b->base == 10)
+    {
+      while (value > UINT32_MAX)
+        {
+          cp = format_decimal (value % 1000000000, 9, cp);
+          value /= 1000000000;
+        }
+      cp = format_decimal (value, 0, cp);
+    }
+  else 
+    {
+      int shift = b->base == 8 ? 3 : 4;
+      unsigned mask = b->base - 1;
+
+      for (; value > 0; value >>= shift)
+        *--cp = b->digits[value & mask];
+    }
+  return cp;
+}
+
+/* Writes the decimal digits of VALUE, with leading zeros to
+   make at least MIN_DIGITS of them, into the bytes just before
+   END and returns the first of them. */
+static char *
+format_decimal (uint32_t value, int min_digits, char *end)
+{
+  char *cp = end;
+
+  while (value >= 100)
+    {
+      const char *pair = &decimal_pairs[value % 100 * 2];
+      value /= 100;
+      *--cp = pair[1];
+      *--cp = pair[0];
+    }
+  if (value >= 10)
+    {
+      *--cp = decimal_pairs[value * 2 + 1];
+      *--cp = decimal_pairs[value * 2];
+    }
+  else if (value > 0)
+    *--cp = '0' + value;
+  while (end - cp < min_digits)
+    *--cp = '0';
+  return cp;
 }
 
 /* Formats the LENGTH characters starting at STRING according to
-   the conversion specified in C.  Writes output to OUTPUT with
-   auxiliary data AUX. */
+   the conversion specified in C.  Writes output to OUT. */
 static void
 format_string (const char *string, int length,
                struct printf_conversion *c,
-               void (*output) (char, void *), void *aux) 
+               struct printf_output *out) 
 {
-  int i;
   if (c->width > length && (c->flags & MINUS) == 0)
-    output_dup (' ', c->width - length, output, aux);
-  for (i = 0; i < length; i++)
-    output (string[i], aux);
+    output_dup (out, ' ', c->width - length);
+  output_chars (out, string, length);
   if (c->width > length && (c->flags & MINUS) != 0)
-    output_dup (' ', c->width - length, output, aux);
+    output_dup (out, ' ', c->width - length);
+}
+
+/* Adds CH to OUT. */
+static inline void
+output_char (struct printf_output *out, char ch) 
+{
+  out->buf[out->len++] = ch;
+  if (out->len >= sizeof out->buf)
+    output_flush (out);
+}
+
+/* Adds the CNT characters in S to OUT.  Runs too long to be
+   worth copying into OUT's buffer go straight to its sink. */
+static void
+output_chars (struct printf_output *out, const char *s, size_t cnt) 
+{
+  if (cnt >= sizeof out->buf)
+    {
+      output_flush (out);
+      out->write (s, cnt, out->aux);
+      return;
+    }
+  while (cnt > 0)
+    {
+      size_t chunk = sizeof out->buf - out->len;
+      if (chunk > cnt)
+        chunk = cnt;
+      memcpy (out->buf + out->len, s, chunk);
+      out->len += chunk;
+      s += chunk;
+      cnt -= chunk;
+      if (out->len >= sizeof out->buf)
+        output_flush (out);
+    }
+}
+
+/* Adds CH to OUT, CNT times. */
+static void
+output_dup (struct printf_output *out, char ch, size_t cnt) 
+{
+  while (cnt > 0)
+    {
+      size_t chunk = sizeof out->buf - out->len;
+      if (chunk > cnt)
+        chunk = cnt;
+      memset (out->buf + out->len, ch, chunk);
+      out->len += chunk;
+      cnt -= chunk;
+      if (out->len >= sizeof out->buf)
+        output_flush (out);
+    }
+}
+
+/* Passes the characters buffered in OUT to its sink. */
+static void
+output_flush (struct printf_output *out) 
+{
+  if (out->len > 0)
+    out->write (out->buf, out->len, out->aux);
+  out->len = 0;
+}
+
+/* Helper function for __vprintf() that passes the N characters
+   in BUFFER to a per-character sink. */
+static void
+output_helper (const char *buffer, size_t n, void *aux_) 
+{
+  struct output_aux *aux = aux_;
+
+  while (n-- > 0)
+    aux->output (*buffer++, aux->aux);
 }
 
 /* Wrapper for __vprintf() that converts varargs into a
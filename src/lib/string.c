@@ -1,5 +1,25 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* memcpy(), memmove(), memset(), memcmp(), and strlen() work a
+   32-bit word at a time where they can.  A word may alias any
+   other type and, because the 80x86 allows it, need not be
+   aligned. */
+typedef uint32_t word_t __attribute__ ((may_alias, aligned (1)));
+#define WORD_SIZE sizeof (word_t)
+
+/* Blocks of at least this many bytes are copied and set with
+   "rep movsl" and "rep stosl", which take a while to start up
+   but then run faster than a loop. */
+#define REP_MIN 64
+
+/* Returns true if word W has a zero byte. */
+static inline int
+has_zero_byte (word_t w) 
+{
+  return ((w - 0x01010101) & ~w & 0x80808080) != 0;
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -12,6 +32,28 @@ memcpy (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
+  if (size >= WORD_SIZE) 
+    {
+      /* Copy bytes until DST is aligned, then words. */
+      for (; (uintptr_t) dst % WORD_SIZE != 0; size--)
+        *dst++ = *src++;
+      if (size >= REP_MIN) 
+        {
+          size_t word_cnt = size / WORD_SIZE;
+          asm volatile ("rep movsl"
+                        : "+D" (dst), "+S" (src), "+c" (word_cnt)
+                        : : "memory");
+        }
+      else
+        for (; size >= WORD_SIZE; size -= WORD_SIZE) 
+          {
+            *(word_t *) dst = *(const word_t *) src;
+            dst += WORD_SIZE;
+            src += WORD_SIZE;
+          }
+      size %= WORD_SIZE;
+    }
+
   while (size-- > 0)
     *dst++ = *src++;
 
@@ -29,20 +71,28 @@ memmove (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  if (dst < src) 
-    {
-      while (size-- > 0)
-        *dst++ = *src++;
-    }
-  else 
+  /* Copying forward is safe unless DST starts inside SRC. */
+  if (dst <= src || dst >= src + size) 
+    return memcpy (dst_, src_, size);
+
+  dst += size;
+  src += size;
+  if (size >= WORD_SIZE) 
     {
-      dst += size;
-      src += size;
-      while (size-- > 0)
+      /* Copy bytes until the end of DST is aligned, then words. */
+      for (; (uintptr_t) dst % WORD_SIZE != 0; size--)
         *--dst = *--src;
+      for (; size >= WORD_SIZE; size -= WORD_SIZE) 
+        {
+          dst -= WORD_SIZE;
+          src -= WORD_SIZE;
+          *(word_t *) dst = *(const word_t *) src;
+        }
     }
+  while (size-- > 0)
+    *--dst = *--src;
 
-  return dst;
+  return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -58,6 +108,13 @@ memcmp (const void *a_, const void *b_, size_t size)
   ASSERT (a != NULL || size == 0);
   ASSERT (b != NULL || size == 0);
 
+  /* Skip over equal words, then find the differing byte. */
+  for (; size >= WORD_SIZE && *(const word_t *) a == *(const word_t *) b;
+       size -= WORD_SIZE) 
+    {
+      a += WORD_SIZE;
+      b += WORD_SIZE;
+    }
   for (; size-- > 0; a++, b++)
     if (*a != *b)
       return *a > *b ? +1 : -1;
@@ -114,8 +171,6 @@ strchr (const char *string, int c_)
 {
   char c = c_;
 
-  ASSERT (string != NULL);
-
   for (;;) 
     if (*string == c)
       return (char *) string;
@@ -281,7 +336,31 @@ memset (void *dst_, int value, size_t size)
   unsigned char *dst = dst_;
 
   ASSERT (dst != NULL || size == 0);
-  
+
+  if (size >= WORD_SIZE) 
+    {
+      word_t word = (unsigned char) value * 0x01010101u;
+
+      /* Set bytes until DST is aligned, then words. */
+      for (; (uintptr_t) dst % WORD_SIZE != 0; size--)
+        *dst++ = value;
+      if (size >= REP_MIN) 
+        {
+          size_t word_cnt = size / WORD_SIZE;
+          asm volatile ("rep stosl"
+                        : "+D" (dst), "+c" (word_cnt)
+                        : "a" (word)
+                        : "memory");
+        }
+      else
+        for (; size >= WORD_SIZE; size -= WORD_SIZE) 
+          {
+            *(word_t *) dst = word;
+            dst += WORD_SIZE;
+          }
+      size %= WORD_SIZE;
+    }
+
   while (size-- > 0)
     *dst++ = value;
 
@@ -294,10 +373,16 @@ strlen (const char *string)
 {
   const char *p;
 
-  ASSERT (string != NULL);
-
-  for (p = string; *p != '\0'; p++)
-    continue;
+  /* Check bytes until P is aligned, then whole words.  An
+     aligned word never crosses into the next page, so reading
+     past the null terminator within one is safe. */
+  for (p = string; (uintptr_t) p % WORD_SIZE != 0; p++)
+    if (*p == '\0')
+      return p - string;
+  while (!has_zero_byte (*(const word_t *) p))
+    p += WORD_SIZE;
+  while (*p != '\0')
+    p++;
   return p - string;
 }
 
@@ -32,7 +32,10 @@ enum
   
     // Project 2 custom system call
     SYS_FIBO,                   /* Returns fibonacci number. */
-    SYS_SUM4                    /* Returns sum of four integers. */
+    SYS_SUM4,                   /* Returns sum of four integers. */
+
+    /* Instrumentation. */
+    SYS_STATS                   /* Reports system call statistics. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -1,14 +1,15 @@
 #include <stdio.h>
-#include <string.h>
 #include <syscall.h>
 #include <syscall-nr.h>
 
 /* The standard vprintf() function,
-   which is like printf() but uses a va_list. */
+   which is like printf() but uses a va_list.
+   Output goes to stdout, which is line buffered, so it reaches
+   the console in one write() system call per line. */
 int
 vprintf (const char *format, va_list args) 
 {
-  return vhprintf (STDOUT_FILENO, format, args);
+  return vfprintf (stdout, format, args);
 }
 
 /* Like printf(), but writes output to the given HANDLE. */
@@ -30,8 +31,8 @@ hprintf (int handle, const char *format, ...)
 int
 puts (const char *s) 
 {
-  write (STDOUT_FILENO, s, strlen (s));
-  putchar ('\n');
+  fputs (s, stdout);
+  fputc ('\n', stdout);
 
   return 0;
 }
@@ -40,55 +41,41 @@ puts (const char *s)
 int
 putchar (int c) 
 {
-  char c2 = c;
-  write (STDOUT_FILENO, &c2, 1);
+  fputc (c, stdout);
   return c;
 }
 
 /* Auxiliary data for vhprintf_helper(). */
 struct vhprintf_aux 
   {
-    char buf[64];       /* Character buffer. */
-    char *p;            /* Current position in buffer. */
     int char_cnt;       /* Total characters written so far. */
     int handle;         /* Output file handle. */
   };
 
-static void add_char (char, void *);
-static void flush (struct vhprintf_aux *);
+static void vhprintf_helper (const char *, size_t, void *);
 
 /* Formats the printf() format specification FORMAT with
    arguments given in ARGS and writes the output to the given
-   HANDLE. */
+   HANDLE, by way of stdout if HANDLE is STDOUT_FILENO. */
 int
 vhprintf (int handle, const char *format, va_list args) 
 {
   struct vhprintf_aux aux;
-  aux.p = aux.buf;
+
+  if (handle == STDOUT_FILENO)
+    return vfprintf (stdout, format, args);
+
   aux.char_cnt = 0;
   aux.handle = handle;
-  __vprintf (format, args, add_char, &aux);
-  flush (&aux);
+  __vprintf_bulk (format, args, vhprintf_helper, &aux);
   return aux.char_cnt;
 }
 
-/* Adds C to the buffer in AUX, flushing it if the buffer fills
-   up. */
+/* Writes the N characters in BUFFER to the handle in AUX. */
 static void
-add_char (char c, void *aux_) 
+vhprintf_helper (const char *buffer, size_t n, void *aux_) 
 {
   struct vhprintf_aux *aux = aux_;
-  *aux->p++ = c;
-  if (aux->p >= aux->buf + sizeof aux->buf)
-    flush (aux);
-  aux->char_cnt++;
-}
-
-/* Flushes the buffer in AUX. */
-static void
-flush (struct vhprintf_aux *aux)
-{
-  if (aux->p > aux->buf)
-    write (aux->handle, aux->buf, aux->p - aux->buf);
-  aux->p = aux->buf;
+  write (aux->handle, buffer, n);
+  aux->char_cnt += n;
 }
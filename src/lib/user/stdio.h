@@ -4,4 +4,52 @@
 int hprintf (int, const char *, ...) PRINTF_FORMAT (2, 3);
 int vhprintf (int, const char *, va_list) PRINTF_FORMAT (2, 0);
 
+/* Buffered streams.
+
+   A stream buffers reads from or writes to a file descriptor in
+   user memory, so that many small fread(), fgetc(), fwrite(),
+   or fputc() calls cost one read() or write() system call per
+   buffer instead of one each.
+
+   There is no malloc() in user programs, so there is a fixed
+   table of FOPEN_MAX streams, including stdin and stdout, each
+   with a default buffer of BUFSIZ bytes.  setvbuf() can supply
+   a larger buffer.  stdin is unbuffered, because reading from
+   the keyboard waits until the whole request is satisfied, and
+   stdout is line buffered.  printf(), puts(), and putchar()
+   write to stdout.  All streams are flushed when the process
+   calls exit(). */
+typedef struct FILE FILE;
+
+extern FILE *stdin;
+extern FILE *stdout;
+
+#define EOF (-1)                /* End of file or error. */
+#define BUFSIZ 512              /* Default buffer size. */
+#define FOPEN_MAX 8             /* Maximum number of streams. */
+
+/* Buffering modes for setvbuf(). */
+#define _IOFBF 0                /* Fully buffered. */
+#define _IOLBF 1                /* Line buffered. */
+#define _IONBF 2                /* Unbuffered. */
+
+FILE *fopen (const char *file, const char *mode);
+int fclose (FILE *);
+int setvbuf (FILE *, char *buffer, int mode, size_t size);
+int fflush (FILE *);
+
+size_t fread (void *, size_t size, size_t cnt, FILE *);
+size_t fwrite (const void *, size_t size, size_t cnt, FILE *);
+int fgetc (FILE *);
+int fputc (int, FILE *);
+char *fgets (char *, int size, FILE *);
+int fputs (const char *, FILE *);
+int fprintf (FILE *, const char *, ...) PRINTF_FORMAT (2, 3);
+int vfprintf (FILE *, const char *, va_list) PRINTF_FORMAT (2, 0);
+
+int feof (FILE *);
+int ferror (FILE *);
+void clearerr (FILE *);
+int fileno (FILE *);
+
 #endif /* lib/user/stdio.h */
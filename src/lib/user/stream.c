@@ -0,0 +1,525 @@
+#include <stdio.h>
+#include <debug.h>
+#include <string.h>
+#include <syscall.h>
+
+/* A buffered stream. */
+struct FILE
+  {
+    int fd;                     /* File descriptor. */
+    int flags;                  /* OPEN, READ, WRITE, AT_EOF, ERROR. */
+    int buf_mode;               /* _IOFBF, _IOLBF, or _IONBF. */
+    enum { IDLE, READING, WRITING } state; /* Direction of BUF's data. */
+    char *buf;                  /* Buffer, or null if not yet chosen. */
+    size_t buf_size;            /* Size of BUF, in bytes. */
+    size_t pos;                 /* Reading: offset of next byte in BUF. */
+    size_t len;                 /* Bytes read into or pending in BUF. */
+    char ch;                    /* Buffer for an unbuffered stream. */
+  };
+
+/* Stream flags. */
+#define OPEN 0x01               /* Slot is in use. */
+#define READ 0x02               /* Open for reading. */
+#define WRITE 0x04              /* Open for writing. */
+#define AT_EOF 0x08             /* End of file has been reached. */
+#define ERROR 0x10              /* A read or write has failed. */
+
+/* All the streams.  The first two are stdin and stdout. */
+static FILE streams[FOPEN_MAX] =
+  {
+    {STDIN_FILENO, OPEN | READ, _IONBF, IDLE, NULL, 0, 0, 0, 0},
+    {STDOUT_FILENO, OPEN | WRITE, _IOLBF, IDLE, NULL, 0, 0, 0, 0},
+  };
+
+/* Default buffers, one for each stream. */
+static char default_bufs[FOPEN_MAX][BUFSIZ];
+
+FILE *stdin = &streams[0];
+FILE *stdout = &streams[1];
+
+static bool start_reading (FILE *);
+static bool start_writing (FILE *);
+static void drop_input (FILE *);
+static bool fill (FILE *);
+static size_t read_bytes (FILE *, char *, size_t);
+static size_t write_bytes (FILE *, const char *, size_t);
+
+/* Opens FILE and returns a stream for it, or a null pointer if
+   FILE cannot be opened or all FOPEN_MAX streams are in use.
+
+   MODE begins with "r" to read, "w" to write, or "a" to write at
+   the end of the file, optionally followed by "+" to allow both
+   reading and writing.  Pintos files have a fixed size given to
+   create() until file growth is implemented, so none of the
+   modes creates or truncates FILE: create it first if needed. */
+FILE *
+fopen (const char *file, const char *mode)
+{
+  FILE *stream;
+  int flags;
+
+  ASSERT (file != NULL);
+  ASSERT (mode != NULL);
+
+  switch (mode[0])
+    {
+    case 'r': flags = READ; break;
+    case 'w': case 'a': flags = WRITE; break;
+    default: return NULL;
+    }
+  if (strchr (mode, '+') != NULL)
+    flags = READ | WRITE;
+
+  for (stream = streams; stream < streams + FOPEN_MAX; stream++)
+    if (!(stream->flags & OPEN))
+      break;
+  if (stream >= streams + FOPEN_MAX)
+    return NULL;
+
+  stream->fd = open (file);
+  if (stream->fd < 0)
+    return NULL;
+  if (mode[0] == 'a')
+    seek (stream->fd, filesize (stream->fd));
+
+  stream->flags = OPEN | flags;
+  stream->buf_mode = _IOFBF;
+  stream->state = IDLE;
+  stream->buf = NULL;
+  stream->buf_size = 0;
+  stream->pos = stream->len = 0;
+  return stream;
+}
+
+/* Flushes and closes STREAM and its file descriptor.  Returns 0
+   if successful, EOF if flushing failed. */
+int
+fclose (FILE *stream)
+{
+  int retval;
+
+  ASSERT (stream->flags & OPEN);
+
+  retval = fflush (stream);
+  close (stream->fd);
+  stream->flags = 0;
+  return retval;
+}
+
+/* Sets STREAM's buffering MODE to _IOFBF, _IOLBF, or _IONBF.
+   For the first two, STREAM uses the SIZE bytes in BUFFER, which
+   must stay valid as long as STREAM is open, or its own BUFSIZ
+   byte buffer if BUFFER is null.  Should be called before
+   STREAM is first used; any output is flushed and any input
+   already buffered is discarded.  Returns 0 if successful,
+   nonzero if MODE is invalid. */
+int
+setvbuf (FILE *stream, char *buffer, int mode, size_t size)
+{
+  ASSERT (stream->flags & OPEN);
+
+  if (mode != _IOFBF && mode != _IOLBF && mode != _IONBF)
+    return EOF;
+  if (buffer != NULL && size == 0)
+    return EOF;
+
+  fflush (stream);
+  drop_input (stream);
+  stream->buf_mode = mode;
+  stream->buf = buffer;
+  stream->buf_size = size;
+  return 0;
+}
+
+/* Writes any output buffered in STREAM to its file, or does
+   the same for every stream if STREAM is null.  Returns 0 if
+   successful, EOF on failure. */
+int
+fflush (FILE *stream)
+{
+  size_t len;
+
+  if (stream == NULL)
+    {
+      int retval = 0;
+
+      for (stream = streams; stream < streams + FOPEN_MAX; stream++)
+        if ((stream->flags & OPEN) && fflush (stream) == EOF)
+          retval = EOF;
+      return retval;
+    }
+
+  if (stream->state != WRITING || stream->len == 0)
+    return 0;
+
+  /* Empty the buffer before writing it, because write() flushes
+     stdout before it writes to STDOUT_FILENO itself. */
+  len = stream->len;
+  stream->len = 0;
+  if (write (stream->fd, stream->buf, len) != (int) len)
+    {
+      stream->flags |= ERROR;
+      return EOF;
+    }
+  return 0;
+}
+
+/* Reads up to CNT objects of SIZE bytes each from STREAM into
+   BUFFER.  Returns the number of whole objects read, which is
+   less than CNT only at end of file or on error. */
+size_t
+fread (void *buffer, size_t size, size_t cnt, FILE *stream)
+{
+  ASSERT (stream->flags & OPEN);
+
+  if (size == 0 || cnt == 0)
+    return 0;
+  return read_bytes (stream, buffer, size * cnt) / size;
+}
+
+/* Writes CNT objects of SIZE bytes each from BUFFER to STREAM.
+   Returns the number of whole objects written, which is less
+   than CNT only on error. */
+size_t
+fwrite (const void *buffer, size_t size, size_t cnt, FILE *stream)
+{
+  ASSERT (stream->flags & OPEN);
+
+  if (size == 0 || cnt == 0)
+    return 0;
+  return write_bytes (stream, buffer, size * cnt) / size;
+}
+
+/* Reads and returns the next byte from STREAM, as an unsigned
+   char converted to int, or EOF at end of file or on error. */
+int
+fgetc (FILE *stream)
+{
+  unsigned char c;
+
+  ASSERT (stream->flags & OPEN);
+
+  if (stream->state == READING && stream->pos < stream->len)
+    return (unsigned char) stream->buf[stream->pos++];
+  return read_bytes (stream, (char *) &c, 1) == 1 ? c : EOF;
+}
+
+/* Writes C, converted to unsigned char, to STREAM.  Returns the
+   byte written, or EOF on error. */
+int
+fputc (int c, FILE *stream)
+{
+  char ch = c;
+
+  ASSERT (stream->flags & OPEN);
+
+  if (stream->state == WRITING && stream->len + 1 < stream->buf_size
+      && (stream->buf_mode == _IOFBF || ch != '\n'))
+    {
+      stream->buf[stream->len++] = ch;
+      return (unsigned char) ch;
+    }
+  return write_bytes (stream, &ch, 1) == 1 ? (unsigned char) ch : EOF;
+}
+
+/* Reads a line from STREAM into the SIZE bytes in BUFFER: at
+   most SIZE - 1 bytes, stopping after a new-line character,
+   followed by a null terminator.  Returns BUFFER, or a null
+   pointer if end of file or an error came before any bytes were
+   read. */
+char *
+fgets (char *buffer, int size, FILE *stream)
+{
+  char *p = buffer;
+  size_t left;
+
+  ASSERT (buffer != NULL);
+  ASSERT (stream->flags & OPEN);
+
+  if (size <= 0)
+    return NULL;
+  for (left = size - 1; left > 0; )
+    {
+      size_t avail, cnt;
+      const char *nl;
+
+      if (stream->state != READING || stream->pos >= stream->len)
+        {
+          if (!start_reading (stream) || !fill (stream))
+            break;
+        }
+
+      /* Copy up to and including a new-line in the buffer. */
+      avail = stream->len - stream->pos;
+      cnt = avail < left ? avail : left;
+      nl = memchr (stream->buf + stream->pos, '\n', cnt);
+      if (nl != NULL)
+        cnt = nl - (stream->buf + stream->pos) + 1;
+      memcpy (p, stream->buf + stream->pos, cnt);
+      stream->pos += cnt;
+      p += cnt;
+      left -= cnt;
+      if (nl != NULL)
+        break;
+    }
+  if (p == buffer && size > 1)
+    return NULL;
+  *p = '\0';
+  return buffer;
+}
+
+/* Writes string S, without its null terminator, to STREAM.
+   Returns 0 if successful, EOF on error. */
+int
+fputs (const char *s, FILE *stream)
+{
+  size_t len = strlen (s);
+
+  ASSERT (stream->flags & OPEN);
+
+  return write_bytes (stream, s, len) == len ? 0 : EOF;
+}
+
+/* Auxiliary data for vfprintf_helper(). */
+struct vfprintf_aux
+  {
+    FILE *stream;       /* Output stream. */
+    int char_cnt;       /* Total characters written so far. */
+  };
+
+static void vfprintf_helper (const char *, size_t, void *);
+
+/* Like printf(), but writes output to STREAM. */
+int
+fprintf (FILE *stream, const char *format, ...)
+{
+  va_list args;
+  int retval;
+
+  va_start (args, format);
+  retval = vfprintf (stream, format, args);
+  va_end (args);
+
+  return retval;
+}
+
+/* Like vprintf(), but writes output to STREAM. */
+int
+vfprintf (FILE *stream, const char *format, va_list args)
+{
+  struct vfprintf_aux aux;
+
+  ASSERT (stream->flags & OPEN);
+
+  aux.stream = stream;
+  aux.char_cnt = 0;
+  __vprintf_bulk (format, args, vfprintf_helper, &aux);
+  return aux.char_cnt;
+}
+
+/* Writes the N characters in BUFFER to the stream in AUX. */
+static void
+vfprintf_helper (const char *buffer, size_t n, void *aux_)
+{
+  struct vfprintf_aux *aux = aux_;
+
+  write_bytes (aux->stream, buffer, n);
+  aux->char_cnt += n;
+}
+
+/* Returns nonzero if a read from STREAM has reached end of
+   file. */
+int
+feof (FILE *stream)
+{
+  return (stream->flags & AT_EOF) != 0;
+}
+
+/* Returns nonzero if a read from or write to STREAM has
+   failed. */
+int
+ferror (FILE *stream)
+{
+  return (stream->flags & ERROR) != 0;
+}
+
+/* Clears STREAM's end-of-file and error indicators. */
+void
+clearerr (FILE *stream)
+{
+  stream->flags &= ~(AT_EOF | ERROR);
+}
+
+/* Returns STREAM's file descriptor. */
+int
+fileno (FILE *stream)
+{
+  return stream->fd;
+}
+
+/* Chooses STREAM's buffer, if it does not have one yet. */
+static void
+choose_buffer (FILE *stream)
+{
+  if (stream->buf == NULL || stream->buf_mode == _IONBF)
+    {
+      if (stream->buf_mode == _IONBF)
+        {
+          stream->buf = &stream->ch;
+          stream->buf_size = 1;
+        }
+      else
+        {
+          stream->buf = default_bufs[stream - streams];
+          if (stream->buf_size == 0 || stream->buf_size > BUFSIZ)
+            stream->buf_size = BUFSIZ;
+        }
+    }
+}
+
+/* Prepares STREAM for reading, flushing any buffered output.
+   Returns false if STREAM is not open for reading. */
+static bool
+start_reading (FILE *stream)
+{
+  if (!(stream->flags & READ))
+    {
+      stream->flags |= ERROR;
+      return false;
+    }
+  if (stream->state != READING)
+    {
+      if (fflush (stream) == EOF)
+        return false;
+      choose_buffer (stream);
+      stream->state = READING;
+      stream->pos = stream->len = 0;
+    }
+  return true;
+}
+
+/* Prepares STREAM for writing, discarding any buffered input.
+   Returns false if STREAM is not open for writing. */
+static bool
+start_writing (FILE *stream)
+{
+  if (!(stream->flags & WRITE))
+    {
+      stream->flags |= ERROR;
+      return false;
+    }
+  if (stream->state != WRITING)
+    {
+      drop_input (stream);
+      choose_buffer (stream);
+      stream->state = WRITING;
+      stream->len = 0;
+    }
+  return true;
+}
+
+/* Discards any input buffered in STREAM, moving its file
+   position back to the first byte not yet consumed, so that the
+   next read or write takes place where the stream's user
+   expects. */
+static void
+drop_input (FILE *stream)
+{
+  if (stream->state == READING)
+    {
+      size_t unread = stream->len - stream->pos;
+      if (unread > 0 && stream->fd != STDIN_FILENO)
+        seek (stream->fd, tell (stream->fd) - unread);
+      stream->pos = stream->len = 0;
+      stream->state = IDLE;
+    }
+}
+
+/* Refills STREAM's buffer, which must be empty, from its file.
+   Returns false and sets STREAM's end-of-file or error
+   indicator if no bytes could be read. */
+static bool
+fill (FILE *stream)
+{
+  int n = read (stream->fd, stream->buf, stream->buf_size);
+
+  stream->pos = 0;
+  stream->len = n > 0 ? n : 0;
+  if (n <= 0)
+    {
+      stream->flags |= n == 0 ? AT_EOF : ERROR;
+      return false;
+    }
+  return true;
+}
+
+/* Reads up to N bytes from STREAM into P and returns the number
+   read.  Requests at least as large as the buffer bypass it once
+   it is empty. */
+static size_t
+read_bytes (FILE *stream, char *p, size_t n)
+{
+  size_t done = 0;
+
+  if (!start_reading (stream))
+    return 0;
+  while (done < n)
+    {
+      size_t avail = stream->len - stream->pos;
+
+      if (avail > 0)
+        {
+          size_t cnt = avail < n - done ? avail : n - done;
+          memcpy (p + done, stream->buf + stream->pos, cnt);
+          stream->pos += cnt;
+          done += cnt;
+        }
+      else if (n - done >= stream->buf_size)
+        {
+          int cnt = read (stream->fd, p + done, n - done);
+          if (cnt <= 0)
+            {
+              stream->flags |= cnt == 0 ? AT_EOF : ERROR;
+              break;
+            }
+          done += cnt;
+        }
+      else if (!fill (stream))
+        break;
+    }
+  return done;
+}
+
+/* Writes the N bytes in P to STREAM and returns the number
+   written.  Writes that do not fit in the buffer flush it, and
+   those at least as large as the buffer then bypass it.  A line
+   buffered stream is flushed whenever P contains a new-line. */
+static size_t
+write_bytes (FILE *stream, const char *p, size_t n)
+{
+  if (!start_writing (stream))
+    return 0;
+
+  if (stream->len + n > stream->buf_size)
+    {
+      if (fflush (stream) == EOF)
+        return 0;
+      if (n >= stream->buf_size)
+        {
+          int cnt = write (stream->fd, p, n);
+          if (cnt != (int) n)
+            {
+              stream->flags |= ERROR;
+              return cnt > 0 ? cnt : 0;
+            }
+          return n;
+        }
+    }
+
+  memcpy (stream->buf + stream->len, p, n);
+  stream->len += n;
+  if (stream->len >= stream->buf_size
+      || (stream->buf_mode == _IOLBF && memchr (p, '\n', n) != NULL))
+    fflush (stream);
+  return n;
+}
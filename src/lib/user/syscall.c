@@ -1,4 +1,5 @@
 #include <syscall.h>
+#include <stdio.h>
 #include "../syscall-nr.h"
 
 /* Invokes syscall NUMBER, passing no arguments, and returns the
@@ -84,6 +85,7 @@
 void
 halt (void) 
 {
+  fflush (NULL);
   syscall0 (SYS_HALT);
   NOT_REACHED ();
 }
@@ -91,6 +93,7 @@ halt (void)
 void
 exit (int status)
 {
+  fflush (NULL);
   syscall1 (SYS_EXIT, status);
   NOT_REACHED ();
 }
@@ -134,12 +137,19 @@ filesize (int fd)
 int
 read (int fd, void *buffer, unsigned size)
 {
+  /* Show any prompt before waiting for input. */
+  if (fd == STDIN_FILENO)
+    fflush (stdout);
   return syscall3 (SYS_READ, fd, buffer, size);
 }
 
 int
 write (int fd, const void *buffer, unsigned size)
 {
+  /* Keep buffered output in order with output written
+     directly. */
+  if (fd == STDOUT_FILENO)
+    fflush (stdout);
   return syscall3 (SYS_WRITE, fd, buffer, size);
 }
 
@@ -214,3 +224,9 @@ sum_of_four_integers (int a, int b, int c, int d)
 {
   return syscall4 (SYS_SUM4, a, b, c, d);
 }
+
+bool
+stats (int syscall_number, struct syscall_stat *stat)
+{
+  return syscall2 (SYS_STATS, syscall_number, stat);
+}
@@ -15,6 +15,20 @@ typedef int mapid_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* System call statistics, as reported by stats(). */
+struct syscall_stat
+  {
+    unsigned long long cnt;         /* Number of calls. */
+    unsigned long long cycles;      /* Total CPU cycles spent in calls. */
+    unsigned long long min_cycles;  /* Fastest call, in CPU cycles. */
+    unsigned long long max_cycles;  /* Slowest call, in CPU cycles. */
+    unsigned long long bytes;       /* Bytes moved by read and write. */
+  };
+
+/* Pass to stats() instead of a system call number to obtain the
+   totals for the calling process. */
+#define STATS_PROCESS (-1)
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
@@ -49,4 +63,7 @@ int inumber (int fd);
 int fibonacci (int);
 int sum_of_four_integers (int, int, int, int);
 
+/* Instrumentation. */
+bool stats (int syscall_number, struct syscall_stat *);
+
 #endif /* lib/user/syscall.h */
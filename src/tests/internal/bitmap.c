@@ -0,0 +1,104 @@
+/* Benchmark for scanning and counting in lib/kernel/bitmap.c.
+
+   Fills a 64K-bit bitmap to various levels with randomly placed
+   set bits, then measures, in CPU cycles, bitmap_scan() for a
+   single unset bit and for a run of 8 unset bits, both from the
+   start of the map, and bitmap_count() over the whole map.  For
+   comparison, also times a scan that tests one bit at a time.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include "threads/test.h"
+#include "threads/tsc.h"
+
+/* Number of bits in the bitmap. */
+#define BIT_CNT 65536
+
+/* Number of times to repeat each measurement. */
+#define REPEAT_CNT 100
+
+static size_t slow_scan (const struct bitmap *, size_t cnt);
+
+void
+test (void)
+{
+  static const int fill_pcts[] = {0, 50, 90, 99, 100};
+  struct bitmap *b;
+  size_t i;
+
+  b = bitmap_create (BIT_CNT);
+  ASSERT (b != NULL);
+
+  printf ("Cycles per call on a %d-bit map:\n", BIT_CNT);
+  for (i = 0; i < sizeof fill_pcts / sizeof *fill_pcts; i++)
+    {
+      int pct = fill_pcts[i];
+      size_t bit, set_cnt, one_cnt, idx1, idx8;
+      uint64_t start, scan1, scan8, count, slow8;
+      int j;
+
+      set_cnt = 0;
+      for (bit = 0; bit < BIT_CNT; bit++)
+        {
+          bool value = (int) (random_ulong () % 100) < pct;
+          bitmap_set (b, bit, value);
+          set_cnt += value;
+        }
+
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        idx1 = bitmap_scan (b, 0, 1, false);
+      scan1 = (rdtsc () - start) / REPEAT_CNT;
+
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        idx8 = bitmap_scan (b, 0, 8, false);
+      scan8 = (rdtsc () - start) / REPEAT_CNT;
+
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        one_cnt = bitmap_count (b, 0, BIT_CNT, true);
+      count = (rdtsc () - start) / REPEAT_CNT;
+
+      start = rdtsc ();
+      ASSERT (slow_scan (b, 8) == idx8);
+      slow8 = rdtsc () - start;
+
+      ASSERT (one_cnt == set_cnt);
+      ASSERT (idx1 == slow_scan (b, 1));
+
+      printf ("  %3d%% full: scan 1 %"PRIu64", scan 8 %"PRIu64
+              " (bit at a time %"PRIu64"), count %"PRIu64"\n",
+              pct, scan1, scan8, slow8, count);
+    }
+
+  bitmap_destroy (b);
+  printf ("done\n");
+}
+
+/* Returns the index of the first run of CNT unset bits in B,
+   testing one bit at a time, or BITMAP_ERROR if there is
+   none. */
+static size_t
+slow_scan (const struct bitmap *b, size_t cnt)
+{
+  size_t i, j;
+
+  for (i = 0; i + cnt <= bitmap_size (b); i++)
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j))
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
@@ -0,0 +1,160 @@
+/* Benchmark for the hash tables in lib/kernel/hash.c.
+
+   Measures, in CPU cycles per operation, inserting, finding, and
+   deleting 1,000, 10,000, and 100,000 integer keys in a chained
+   struct hash and in an open-addressing struct ohash, and checks
+   that both tables find exactly the keys they should.
+
+   The largest tables need several megabytes of kernel memory,
+   so run with a larger memory size (e.g. "pintos -m 32") to
+   measure them; sizes that do not fit are skipped.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <hash.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "threads/malloc.h"
+#include "threads/test.h"
+#include "threads/tsc.h"
+
+/* A hashed integer. */
+struct item
+  {
+    struct hash_elem elem;
+    int key;
+  };
+
+/* Operations on one kind of hash table. */
+struct table_ops
+  {
+    const char *name;
+    bool (*init) (void *, hash_hash_func *, hash_less_func *, void *aux);
+    struct hash_elem *(*insert) (void *, struct hash_elem *);
+    struct hash_elem *(*find) (void *, struct hash_elem *);
+    struct hash_elem *(*delete) (void *, struct hash_elem *);
+    void (*destroy) (void *, hash_action_func *);
+  };
+
+static bool hash_init_ (void *h, hash_hash_func *hash, hash_less_func *less,
+                        void *aux) { return hash_init (h, hash, less, aux); }
+static struct hash_elem *hash_insert_ (void *h, struct hash_elem *e)
+  { return hash_insert (h, e); }
+static struct hash_elem *hash_find_ (void *h, struct hash_elem *e)
+  { return hash_find (h, e); }
+static struct hash_elem *hash_delete_ (void *h, struct hash_elem *e)
+  { return hash_delete (h, e); }
+static void hash_destroy_ (void *h, hash_action_func *destructor)
+  { hash_destroy (h, destructor); }
+static bool ohash_init_ (void *h, hash_hash_func *hash, hash_less_func *less,
+                         void *aux) { return ohash_init (h, hash, less, aux); }
+static struct hash_elem *ohash_insert_ (void *h, struct hash_elem *e)
+  { return ohash_insert (h, e); }
+static struct hash_elem *ohash_find_ (void *h, struct hash_elem *e)
+  { return ohash_find (h, e); }
+static struct hash_elem *ohash_delete_ (void *h, struct hash_elem *e)
+  { return ohash_delete (h, e); }
+static void ohash_destroy_ (void *h, hash_action_func *destructor)
+  { ohash_destroy (h, destructor); }
+
+static hash_hash_func item_hash;
+static hash_less_func item_less;
+static void measure (const struct table_ops *, void *table,
+                     struct item *, int cnt);
+
+void
+test (void)
+{
+  static const int sizes[] = {1000, 10000, 100000};
+  const struct table_ops ops[2] =
+    {
+      {"hash", hash_init_, hash_insert_, hash_find_, hash_delete_,
+       hash_destroy_},
+      {"ohash", ohash_init_, ohash_insert_, ohash_find_, ohash_delete_,
+       ohash_destroy_},
+    };
+  struct hash hash;
+  struct ohash ohash;
+  size_t i;
+
+  printf ("Cycles per insert, find, and delete:\n");
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    {
+      int cnt = sizes[i];
+      struct item *items = malloc (sizeof *items * cnt);
+      int j;
+
+      if (items == NULL)
+        {
+          printf ("  %6d keys: skipped, out of memory\n", cnt);
+          continue;
+        }
+      for (j = 0; j < cnt; j++)
+        items[j].key = j * 7919;
+
+      measure (&ops[0], &hash, items, cnt);
+      measure (&ops[1], &ohash, items, cnt);
+      free (items);
+    }
+
+  printf ("done\n");
+}
+
+/* Inserts, finds, and deletes the CNT ITEMS in TABLE, using OPS,
+   and prints the average cost of each. */
+static void
+measure (const struct table_ops *ops, void *table,
+         struct item *items, int cnt)
+{
+  uint64_t start, insert, find, delete;
+  struct item missing;
+  int j;
+
+  if (!ops->init (table, item_hash, item_less, NULL))
+    {
+      printf ("  %6d keys, %-5s: skipped, out of memory\n", cnt, ops->name);
+      return;
+    }
+
+  start = rdtsc ();
+  for (j = 0; j < cnt; j++)
+    ASSERT (ops->insert (table, &items[j].elem) == NULL);
+  insert = (rdtsc () - start) / cnt;
+
+  start = rdtsc ();
+  for (j = 0; j < cnt; j++)
+    ASSERT (ops->find (table, &items[j].elem) == &items[j].elem);
+  find = (rdtsc () - start) / cnt;
+
+  missing.key = -1;
+  ASSERT (ops->find (table, &missing.elem) == NULL);
+
+  start = rdtsc ();
+  for (j = 0; j < cnt; j++)
+    ASSERT (ops->delete (table, &items[j].elem) == &items[j].elem);
+  delete = (rdtsc () - start) / cnt;
+
+  ASSERT (ops->find (table, &items[0].elem) == NULL);
+  ops->destroy (table, NULL);
+
+  printf ("  %6d keys, %-5s: insert %"PRIu64", find %"PRIu64
+          ", delete %"PRIu64"\n", cnt, ops->name, insert, find, delete);
+}
+
+static unsigned
+item_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_int (hash_entry (e, struct item, elem)->key);
+}
+
+static bool
+item_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED)
+{
+  return (hash_entry (a, struct item, elem)->key
+          < hash_entry (b, struct item, elem)->key);
+}
@@ -0,0 +1,127 @@
+/* Benchmark for malloc() and free() in threads/malloc.c.
+
+   Measures, in CPU cycles, the cost of a malloc() and free()
+   pair for each size class, and of a loop that allocates and
+   frees every block of an arena, which used to get and free a
+   page each time around.  Also checks that blocks do not
+   overlap, and counts how often realloc() moves a buffer that
+   grows a page at a time.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/test.h"
+#include "threads/tsc.h"
+#include "threads/vaddr.h"
+
+/* Number of malloc() and free() pairs to time. */
+#define PAIR_CNT 10000
+
+/* Maximum number of blocks to hold at once. */
+#define MAX_BLOCKS 512
+
+static void *blocks[MAX_BLOCKS];
+
+static void check_blocks (size_t size, size_t cnt);
+
+void
+test (void)
+{
+  size_t size;
+
+  printf ("malloc() and free() pairs, in cycles per pair:\n");
+  for (size = 16; size <= 1024; size *= 2)
+    {
+      uint64_t start;
+      int i;
+
+      start = rdtsc ();
+      for (i = 0; i < PAIR_CNT; i++)
+        {
+          void *p = malloc (size);
+          ASSERT (p != NULL);
+          free (p);
+        }
+      printf ("  %4zu bytes: %"PRIu64"\n", size, (rdtsc () - start) / PAIR_CNT);
+    }
+
+  printf ("Filling and emptying a page of blocks, in cycles per block:\n");
+  for (size = 16; size <= 1024; size *= 2)
+    {
+      size_t cnt = PGSIZE / size - 1;
+      uint64_t start;
+      int round;
+
+      if (cnt > MAX_BLOCKS)
+        cnt = MAX_BLOCKS;
+      check_blocks (size, cnt);
+
+      start = rdtsc ();
+      for (round = 0; round < PAIR_CNT / (int) cnt; round++)
+        {
+          size_t i;
+
+          for (i = 0; i < cnt; i++)
+            blocks[i] = malloc (size);
+          for (i = 0; i < cnt; i++)
+            free (blocks[i]);
+        }
+      printf ("  %4zu bytes: %"PRIu64"\n", size,
+              (rdtsc () - start) / (PAIR_CNT / cnt * cnt));
+    }
+
+  printf ("Growing a buffer with realloc() a page at a time:\n");
+  {
+    uint8_t *buf = NULL;
+    size_t moves = 0;
+    uint64_t start = rdtsc ();
+
+    for (size = PGSIZE; size <= 16 * PGSIZE; size += PGSIZE)
+      {
+        uint8_t *new_buf = realloc (buf, size);
+        ASSERT (new_buf != NULL);
+        if (buf != NULL && new_buf != buf)
+          {
+            ASSERT (new_buf[size - PGSIZE - 1] == 0x5a);
+            moves++;
+          }
+        new_buf[size - 1] = 0x5a;
+        buf = new_buf;
+      }
+    printf ("  16 resizes, %zu moves, %"PRIu64" cycles per resize\n",
+            moves, (rdtsc () - start) / 16);
+    free (buf);
+  }
+
+  printf ("done\n");
+}
+
+/* Allocates CNT blocks of SIZE bytes, fills each with a distinct
+   byte, and checks that none was overwritten, then frees
+   them. */
+static void
+check_blocks (size_t size, size_t cnt)
+{
+  size_t i, j;
+
+  for (i = 0; i < cnt; i++)
+    {
+      blocks[i] = malloc (size);
+      ASSERT (blocks[i] != NULL);
+      memset (blocks[i], i & 0xff, size);
+    }
+  for (i = 0; i < cnt; i++)
+    {
+      const uint8_t *p = blocks[i];
+      for (j = 0; j < size; j++)
+        ASSERT (p[j] == (i & 0xff));
+      free (blocks[i]);
+    }
+}
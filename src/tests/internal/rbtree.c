@@ -0,0 +1,298 @@
+/* Test program for lib/kernel/rbtree.c.
+
+   Inserts and removes elements in random order in trees of
+   various sizes, checking the red-black invariants, the order of
+   the elements, searches, and an augmented interval query after
+   each step.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <rbtree.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Maximum number of elements in a tree that we will test. */
+#define MAX_SIZE 64
+
+/* A tree element: the interval [START, END). */
+struct value
+  {
+    struct rb_elem elem;        /* Tree element. */
+    int start;                  /* Item value, the interval's start. */
+    int end;                    /* End of interval. */
+    int max_end;                /* Largest END in this subtree. */
+    int seq;                    /* Order of insertion among equals. */
+  };
+
+static void shuffle (struct value *[], size_t);
+static bool value_less (const struct rb_elem *, const struct rb_elem *,
+                        void *);
+static void value_update (struct rb_elem *, void *);
+static int start_of (struct rb_elem *);
+static void verify_tree (struct rbtree *, int size);
+static int verify_subtree (struct rb_elem *, struct rb_elem *parent);
+static int count_overlaps (struct rb_elem *, int point);
+
+/* Test the red-black tree implementation. */
+void
+test (void)
+{
+  int size;
+
+  printf ("testing various size trees:");
+  for (size = 0; size < MAX_SIZE; size++)
+    {
+      int repeat;
+
+      printf (" %d", size);
+      for (repeat = 0; repeat < 10; repeat++)
+        {
+          static struct value values[MAX_SIZE * 4];
+          static struct value *order[MAX_SIZE * 4];
+          struct rbtree tree;
+          struct rb_elem *e;
+          struct value key;
+          int i, ofs;
+
+          /* Put values 0, 2, ..., 2 * (SIZE - 1) in random order in
+             ORDER and insert them. */
+          for (i = 0; i < size; i++)
+            {
+              values[i].start = i * 2;
+              values[i].end = i * 2 + 1 + random_ulong () % 8;
+              values[i].seq = 0;
+              order[i] = &values[i];
+            }
+          shuffle (order, size);
+          rb_init (&tree, value_less, value_update, NULL);
+          for (i = 0; i < size; i++)
+            {
+              rb_insert (&tree, &order[i]->elem);
+              verify_subtree (rb_root (&tree), NULL);
+            }
+          verify_tree (&tree, size);
+
+          /* Verify correct minimum and maximum elements. */
+          ASSERT (start_of (rb_min (&tree)) == (size ? 0 : -1));
+          ASSERT (start_of (rb_max (&tree)) == (size ? 2 * size - 2 : -1));
+
+          /* Verify searches for values in and between elements. */
+          for (i = -1; i <= 2 * size; i++)
+            {
+              key.start = i;
+              ASSERT (start_of (rb_find (&tree, &key.elem))
+                      == (i >= 0 && i < 2 * size && i % 2 == 0 ? i : -1));
+              ASSERT (start_of (rb_lower_bound (&tree, &key.elem))
+                      == (i < 2 * size - 1 ? (i + 1) / 2 * 2 : -1));
+              ASSERT (start_of (rb_upper_bound (&tree, &key.elem))
+                      == (i < 2 * size - 2 ? (i + 2) / 2 * 2 : -1));
+            }
+
+          /* Verify interval queries against a linear search. */
+          for (i = 0; i < 2 * size + 8; i++)
+            {
+              int expected = 0;
+              int j;
+
+              for (j = 0; j < size; j++)
+                if (values[j].start <= i && i < values[j].end)
+                  expected++;
+              ASSERT (count_overlaps (rb_root (&tree), i) == expected);
+            }
+
+          /* Duplicate some items and verify that equal items stay
+             in order of insertion. */
+          ofs = size;
+          for (i = 0; i < size; i++)
+            {
+              int copies = random_ulong () % 4;
+              int seq;
+
+              for (seq = 1; seq <= copies; seq++)
+                {
+                  values[ofs] = values[i];
+                  values[ofs].seq = seq;
+                  rb_insert (&tree, &values[ofs++].elem);
+                }
+            }
+          ASSERT ((size_t) ofs < sizeof values / sizeof *values);
+          verify_subtree (rb_root (&tree), NULL);
+          for (e = rb_min (&tree); e != NULL && rb_next (e) != NULL;
+               e = rb_next (e))
+            {
+              struct value *a = rb_entry (e, struct value, elem);
+              struct value *b = rb_entry (rb_next (e), struct value, elem);
+              ASSERT (a->start < b->start
+                      || (a->start == b->start && a->seq + 1 == b->seq));
+            }
+
+          /* Remove the duplicates, in random order, and verify. */
+          for (i = size; i < ofs; i++)
+            order[i - size] = &values[i];
+          shuffle (order, ofs - size);
+          for (i = 0; i < ofs - size; i++)
+            {
+              rb_remove (&tree, &order[i]->elem);
+              verify_subtree (rb_root (&tree), NULL);
+            }
+          verify_tree (&tree, size);
+
+          /* Remove all the original items, in random order. */
+          for (i = 0; i < size; i++)
+            order[i] = &values[i];
+          shuffle (order, size);
+          for (i = 0; i < size; i++)
+            {
+              rb_remove (&tree, &order[i]->elem);
+              ASSERT (rb_size (&tree) == (size_t) (size - i - 1));
+              verify_subtree (rb_root (&tree), NULL);
+            }
+          ASSERT (rb_empty (&tree));
+        }
+    }
+
+  printf (" done\n");
+  printf ("rbtree: PASS\n");
+}
+
+/* Shuffles the CNT elements in ARRAY into random order. */
+static void
+shuffle (struct value **array, size_t cnt)
+{
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      size_t j = i + random_ulong () % (cnt - i);
+      struct value *t = array[j];
+      array[j] = array[i];
+      array[i] = t;
+    }
+}
+
+/* Returns true if value A is less than value B, false
+   otherwise. */
+static bool
+value_less (const struct rb_elem *a_, const struct rb_elem *b_,
+            void *aux UNUSED)
+{
+  const struct value *a = rb_entry (a_, struct value, elem);
+  const struct value *b = rb_entry (b_, struct value, elem);
+
+  return a->start < b->start;
+}
+
+/* Returns the start of E's interval, or -1 if E is null. */
+static int
+start_of (struct rb_elem *e)
+{
+  return e != NULL ? rb_entry (e, struct value, elem)->start : -1;
+}
+
+/* Recomputes the largest END in E's subtree. */
+static void
+value_update (struct rb_elem *e, void *aux UNUSED)
+{
+  struct value *v = rb_entry (e, struct value, elem);
+
+  v->max_end = v->end;
+  if (e->left != NULL
+      && rb_entry (e->left, struct value, elem)->max_end > v->max_end)
+    v->max_end = rb_entry (e->left, struct value, elem)->max_end;
+  if (e->right != NULL
+      && rb_entry (e->right, struct value, elem)->max_end > v->max_end)
+    v->max_end = rb_entry (e->right, struct value, elem)->max_end;
+}
+
+/* Verifies that TREE contains the values 0, 2, ..., 2 * (SIZE -
+   1) when traversed in forward and in reverse order, and that it
+   satisfies its invariants. */
+static void
+verify_tree (struct rbtree *tree, int size)
+{
+  struct rb_elem *e;
+  int i;
+
+  ASSERT (rb_size (tree) == (size_t) size);
+  verify_subtree (rb_root (tree), NULL);
+
+  for (i = 0, e = rb_min (tree); i < size && e != NULL; i++, e = rb_next (e))
+    ASSERT (rb_entry (e, struct value, elem)->start == 2 * i);
+  ASSERT (i == size);
+  ASSERT (e == NULL);
+
+  for (i = size - 1, e = rb_max (tree); i >= 0 && e != NULL;
+       i--, e = rb_prev (e))
+    ASSERT (rb_entry (e, struct value, elem)->start == 2 * i);
+  ASSERT (i == -1);
+  ASSERT (e == NULL);
+}
+
+/* Verifies that the subtree rooted at E, whose parent is PARENT,
+   has correct parent pointers, is ordered, has no red element
+   with a red child, has the same number of black elements on
+   every path, and has correct MAX_END values.  Returns the
+   number of black elements on each path. */
+static int
+verify_subtree (struct rb_elem *e, struct rb_elem *parent)
+{
+  struct value *v;
+  int left_black, right_black, max_end;
+
+  if (e == NULL)
+    return 1;
+
+  v = rb_entry (e, struct value, elem);
+  ASSERT (e->parent == parent);
+  ASSERT (parent != NULL || !e->red);
+  ASSERT (!e->red || ((e->left == NULL || !e->left->red)
+                      && (e->right == NULL || !e->right->red)));
+  ASSERT (e->left == NULL
+          || rb_entry (e->left, struct value, elem)->start <= v->start);
+  ASSERT (e->right == NULL
+          || rb_entry (e->right, struct value, elem)->start >= v->start);
+
+  max_end = v->end;
+  if (e->left != NULL
+      && rb_entry (e->left, struct value, elem)->max_end > max_end)
+    max_end = rb_entry (e->left, struct value, elem)->max_end;
+  if (e->right != NULL
+      && rb_entry (e->right, struct value, elem)->max_end > max_end)
+    max_end = rb_entry (e->right, struct value, elem)->max_end;
+  ASSERT (v->max_end == max_end);
+
+  left_black = verify_subtree (e->left, e);
+  right_black = verify_subtree (e->right, e);
+  ASSERT (left_black == right_black);
+  return left_black + !e->red;
+}
+
+/* Returns the number of intervals in the subtree rooted at E
+   that contain POINT, skipping subtrees that end at or before
+   POINT and subtrees that start after it. */
+static int
+count_overlaps (struct rb_elem *e, int point)
+{
+  struct value *v;
+  int cnt;
+
+  if (e == NULL)
+    return 0;
+  v = rb_entry (e, struct value, elem);
+  if (v->max_end <= point)
+    return 0;
+
+  cnt = count_overlaps (e->left, point);
+  if (v->start <= point)
+    {
+      if (point < v->end)
+        cnt++;
+      cnt += count_overlaps (e->right, point);
+    }
+  return cnt;
+}
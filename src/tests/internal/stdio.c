@@ -22,7 +22,7 @@ static int failure_cnt;
 static void
 checkf (const char *expect, const char *format, ...) 
 {
-  char output[128];
+  char output[256];
   va_list args;
 
   printf ("\"%s\" -> \"%s\": ", format, expect);
@@ -201,6 +201,30 @@ test (void)
   checkf ("-155209728", "%zd", (size_t) -155209728);
   checkf ("-155209728", "%+zi", (size_t) -155209728);
 
+  /* Decimal conversions around the points where the digits
+     switch between 32-bit and 64-bit arithmetic. */
+  checkf ("4294967295", "%u", 4294967295U);
+  checkf ("4294967296", "%llu", 4294967296ULL);
+  checkf ("1000000000", "%llu", 1000000000ULL);
+  checkf ("10000000000000000000", "%llu", 10000000000000000000ULL);
+  checkf ("18446744073709551615", "%llu", 18446744073709551615ULL);
+  checkf ("-9223372036854775808", "%lld", LLONG_MIN);
+  checkf ("00000000000000000001", "%020llu", 1ULL);
+  checkf ("1777777777777777777777", "%llo", 18446744073709551615ULL);
+  checkf ("ffffffffffffffff", "%llx", 18446744073709551615ULL);
+
+  /* Output that spans more than one internal buffer. */
+  checkf ("                                                            "
+          "                                                            "
+          "                                                          42",
+          "%180d", 42);
+  checkf ("0123456789012345678901234567890123456789012345678901234567890"
+          "1234567890123456789012345678901234567890123456789012345678901"
+          "23456789-", "%s-",
+          "0123456789012345678901234567890123456789012345678901234567890"
+          "1234567890123456789012345678901234567890123456789012345678901"
+          "23456789");
+
   if (failure_cnt == 0)
     printf ("\nstdio: PASS\n");
   else
@@ -0,0 +1,185 @@
+/* Benchmark for memcpy(), memset(), memcmp(), and strlen() in
+   lib/string.c.
+
+   Measures, in CPU cycles per byte, each function and a simple
+   byte-at-a-time loop doing the same work, on blocks of 16 bytes,
+   512 bytes, and 4 kB.  Also checks that each function gets the
+   same answer as the loop at every alignment.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/test.h"
+#include "threads/tsc.h"
+
+/* Number of times to repeat each measurement. */
+#define REPEAT_CNT 1000
+
+/* Largest block size, plus room for misalignment. */
+#define BUF_SIZE (4096 + 8)
+
+static uint8_t buf_a[BUF_SIZE], buf_b[BUF_SIZE];
+
+static void byte_memcpy (void *, const void *, size_t);
+static void byte_memset (void *, int, size_t);
+static int byte_memcmp (const void *, const void *, size_t);
+static size_t byte_strlen (const char *);
+static void check (size_t size);
+static void print_rate (const char *what, size_t size, uint64_t cycles);
+
+void
+test (void)
+{
+  static const size_t sizes[] = {16, 512, 4096};
+  size_t i;
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    check (sizes[i]);
+
+  printf ("Cycles per byte, lib/string.c versus byte loop:\n");
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    {
+      size_t size = sizes[i];
+      uint64_t start;
+      int j;
+
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        memcpy (buf_a, buf_b, size);
+      print_rate ("memcpy", size, rdtsc () - start);
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        byte_memcpy (buf_a, buf_b, size);
+      print_rate ("  loop", size, rdtsc () - start);
+
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        memset (buf_a, j, size);
+      print_rate ("memset", size, rdtsc () - start);
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        byte_memset (buf_a, j, size);
+      print_rate ("  loop", size, rdtsc () - start);
+
+      memset (buf_a, 'x', size);
+      memset (buf_b, 'x', size);
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        ASSERT (memcmp (buf_a, buf_b, size) == 0);
+      print_rate ("memcmp", size, rdtsc () - start);
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        ASSERT (byte_memcmp (buf_a, buf_b, size) == 0);
+      print_rate ("  loop", size, rdtsc () - start);
+
+      buf_a[size - 1] = '\0';
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        ASSERT (strlen ((char *) buf_a) == size - 1);
+      print_rate ("strlen", size, rdtsc () - start);
+      start = rdtsc ();
+      for (j = 0; j < REPEAT_CNT; j++)
+        ASSERT (byte_strlen ((char *) buf_a) == size - 1);
+      print_rate ("  loop", size, rdtsc () - start);
+    }
+
+  printf ("done\n");
+}
+
+/* Checks memcpy(), memmove(), memset(), memcmp(), and strlen()
+   on blocks of SIZE bytes at each combination of alignments. */
+static void
+check (size_t size)
+{
+  int ofs_a, ofs_b;
+
+  for (ofs_a = 0; ofs_a < 4; ofs_a++)
+    for (ofs_b = 0; ofs_b < 4; ofs_b++)
+      {
+        uint8_t *a = buf_a + ofs_a;
+        uint8_t *b = buf_b + ofs_b;
+        size_t i;
+
+        for (i = 0; i < size; i++)
+          b[i] = i % 251 + 1;
+        memcpy (a, b, size);
+        ASSERT (byte_memcmp (a, b, size) == 0);
+        ASSERT (memcmp (a, b, size) == 0);
+
+        a[size / 2]++;
+        ASSERT (memcmp (a, b, size) > 0);
+        ASSERT (memcmp (b, a, size) < 0);
+
+        b[size - 1] = '\0';
+        ASSERT (strlen ((char *) b) == size - 1);
+
+        memmove (b + 1, b, size - 1);
+        for (i = 1; i < size; i++)
+          ASSERT (b[i] == (i - 1) % 251 + 1);
+        memmove (b, b + 1, size - 1);
+        for (i = 0; i < size - 1; i++)
+          ASSERT (b[i] == i % 251 + 1);
+
+        memset (a, 0x5a, size - 1);
+        for (i = 0; i < size - 1; i++)
+          ASSERT (a[i] == 0x5a);
+      }
+}
+
+/* Prints CYCLES, the time for REPEAT_CNT operations on SIZE
+   bytes each, as cycles per byte with two decimal places. */
+static void
+print_rate (const char *what, size_t size, uint64_t cycles)
+{
+  uint64_t hundredths = cycles * 100 / (REPEAT_CNT * size);
+
+  printf ("  %s %4zu bytes: %"PRIu64".%02"PRIu64"\n",
+          what, size, hundredths / 100, hundredths % 100);
+}
+
+static void
+byte_memcpy (void *dst_, const void *src_, size_t size)
+{
+  uint8_t *dst = dst_;
+  const uint8_t *src = src_;
+
+  while (size-- > 0)
+    *dst++ = *src++;
+}
+
+static void
+byte_memset (void *dst_, int value, size_t size)
+{
+  uint8_t *dst = dst_;
+
+  while (size-- > 0)
+    *dst++ = value;
+}
+
+static int
+byte_memcmp (const void *a_, const void *b_, size_t size)
+{
+  const uint8_t *a = a_;
+  const uint8_t *b = b_;
+
+  for (; size-- > 0; a++, b++)
+    if (*a != *b)
+      return *a > *b ? +1 : -1;
+  return 0;
+}
+
+static size_t
+byte_strlen (const char *string)
+{
+  const char *p;
+
+  for (p = string; *p != '\0'; p++)
+    continue;
+  return p - string;
+}
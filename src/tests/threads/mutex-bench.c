@@ -0,0 +1,115 @@
+/* Measures the cost, in CPU cycles, of acquiring and releasing a
+   struct lock and a struct mutex, first without contention and
+   then with two threads that contend on every iteration.
+
+   In the contended case, each thread yields while holding the
+   lock, so that the other thread always finds it held and must
+   wait, and every iteration includes a handoff. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+
+/* Number of iterations in each uncontended measurement. */
+#define UNCONTENDED_ITERS 10000
+
+/* Number of iterations per thread in each contended
+   measurement. */
+#define CONTENDED_ITERS 1000
+
+/* Acquires or releases a lock or mutex. */
+struct lock_ops
+  {
+    const char *name;
+    void (*acquire) (void *);
+    void (*release) (void *);
+    void *lock;
+  };
+
+/* State shared by the contending threads. */
+struct contender
+  {
+    const struct lock_ops *ops;
+    struct semaphore done;
+  };
+
+static struct lock lock;
+static struct mutex mutex;
+
+static void lock_acquire_ (void *l) { lock_acquire (l); }
+static void lock_release_ (void *l) { lock_release (l); }
+static void mutex_lock_ (void *m) { mutex_lock (m); }
+static void mutex_unlock_ (void *m) { mutex_unlock (m); }
+
+static void measure (const struct lock_ops *);
+static thread_func contender_thread;
+
+void
+test_mutex_bench (void) 
+{
+  struct lock_ops ops[2] =
+    {
+      {"struct lock", lock_acquire_, lock_release_, &lock},
+      {"struct mutex", mutex_lock_, mutex_unlock_, &mutex},
+    };
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&lock);
+  mutex_init (&mutex);
+  for (i = 0; i < 2; i++)
+    measure (&ops[i]);
+  pass ();
+}
+
+/* Measures and prints the uncontended and contended cost of
+   OPS. */
+static void
+measure (const struct lock_ops *ops) 
+{
+  struct contender c;
+  uint64_t start, uncontended, contended;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < UNCONTENDED_ITERS; i++) 
+    {
+      ops->acquire (ops->lock);
+      ops->release (ops->lock);
+    }
+  uncontended = (rdtsc () - start) / UNCONTENDED_ITERS;
+
+  c.ops = ops;
+  sema_init (&c.done, 0);
+  start = rdtsc ();
+  thread_create ("contender", PRI_DEFAULT, contender_thread, &c);
+  contender_thread (&c);
+  sema_down (&c.done);
+  sema_down (&c.done);
+  contended = (rdtsc () - start) / (2 * CONTENDED_ITERS);
+
+  msg ("%s: %d cycles uncontended, %d cycles contended.",
+       ops->name, (int) uncontended, (int) contended);
+}
+
+/* Acquires and releases C's lock CONTENDED_ITERS times,
+   yielding while holding it. */
+static void
+contender_thread (void *c_) 
+{
+  struct contender *c = c_;
+  int i;
+
+  for (i = 0; i < CONTENDED_ITERS; i++) 
+    {
+      c->ops->acquire (c->ops->lock);
+      thread_yield ();
+      c->ops->release (c->ops->lock);
+    }
+  sema_up (&c->done);
+}
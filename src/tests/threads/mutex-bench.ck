@@ -0,0 +1,35 @@
+# -*- perl -*-
+
+# The expected output looks like this, with different cycle
+# counts:
+#
+# (mutex-bench) begin
+# (mutex-bench) struct lock: 412 cycles uncontended, 3120 cycles contended.
+# (mutex-bench) struct mutex: 57 cycles uncontended, 2984 cycles contended.
+# (mutex-bench) PASS
+# (mutex-bench) end
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "5 lines of output expected but " . scalar (@output) . " found\n"
+  if @output != 5;
+
+fail "Missing begin line.\n" if $output[0] ne '(mutex-bench) begin';
+my ($i) = 1;
+for my $name ('lock', 'mutex') {
+    fail "Malformed struct $name result: $output[$i]\n"
+      if $output[$i] !~ /^\(mutex-bench\) struct $name: \d+ cycles uncontended, \d+ cycles contended\.$/;
+    $i++;
+}
+fail "Missing PASS line.\n" if $output[3] ne '(mutex-bench) PASS';
+fail "Missing end line.\n" if $output[4] ne '(mutex-bench) end';
+
+pass;
@@ -0,0 +1,129 @@
+/* Stresses the page allocator by allocating and freeing runs of
+   random length, in random order, from both pools.  Marks every
+   page of a run when it is allocated and checks the marks before
+   freeing it, to catch runs that overlap.
+
+   Reports the distribution of the cost, in CPU cycles, of each
+   allocation and free, in power-of-2 buckets. */
+
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/tsc.h"
+#include "threads/vaddr.h"
+
+/* Number of runs held at once, at most. */
+#define SLOT_CNT 32
+
+/* Longest run, in pages. */
+#define MAX_RUN 8
+
+/* Number of allocations and frees. */
+#define OP_CNT 20000
+
+/* Number of latency buckets.  Bucket I counts operations that
+   took fewer than 2**(I + 6) cycles; the last bucket counts the
+   rest. */
+#define BUCKET_CNT 12
+
+/* A run of pages. */
+struct run
+  {
+    uint8_t *pages;             /* First page, or null if unused. */
+    size_t page_cnt;            /* Number of pages. */
+  };
+
+static struct run runs[SLOT_CNT];
+
+static void record (int *buckets, uint64_t cycles);
+static void print_buckets (const char *what, const int *buckets);
+
+void
+test_palloc_stress (void)
+{
+  int alloc_buckets[BUCKET_CNT] = {0};
+  int free_buckets[BUCKET_CNT] = {0};
+  int failures = 0;
+  int op, i;
+
+  for (op = 0; op < OP_CNT; op++)
+    {
+      int slot = random_ulong () % SLOT_CNT;
+      struct run *r = &runs[slot];
+      uint64_t start;
+      size_t j;
+
+      if (r->pages == NULL)
+        {
+          size_t page_cnt = random_ulong () % MAX_RUN + 1;
+          enum palloc_flags flags = slot % 2 ? PAL_USER : 0;
+
+          start = rdtsc ();
+          r->pages = palloc_get_multiple (flags, page_cnt);
+          record (alloc_buckets, rdtsc () - start);
+          if (r->pages == NULL)
+            {
+              failures++;
+              continue;
+            }
+
+          r->page_cnt = page_cnt;
+          for (j = 0; j < page_cnt; j++)
+            r->pages[j * PGSIZE] = r->pages[j * PGSIZE + PGSIZE - 1] = slot;
+        }
+      else
+        {
+          for (j = 0; j < r->page_cnt; j++)
+            if (r->pages[j * PGSIZE] != slot
+                || r->pages[j * PGSIZE + PGSIZE - 1] != slot)
+              fail ("page %zu of run in slot %d was overwritten", j, slot);
+
+          start = rdtsc ();
+          palloc_free_multiple (r->pages, r->page_cnt);
+          record (free_buckets, rdtsc () - start);
+          r->pages = NULL;
+        }
+    }
+
+  for (i = 0; i < SLOT_CNT; i++)
+    if (runs[i].pages != NULL)
+      {
+        palloc_free_multiple (runs[i].pages, runs[i].page_cnt);
+        runs[i].pages = NULL;
+      }
+
+  msg ("%d operations, %d failed allocations.", OP_CNT, failures);
+  print_buckets ("allocation", alloc_buckets);
+  print_buckets ("free", free_buckets);
+  pass ();
+}
+
+/* Counts an operation that took CYCLES in BUCKETS. */
+static void
+record (int *buckets, uint64_t cycles)
+{
+  int i;
+
+  for (i = 0; i < BUCKET_CNT - 1; i++)
+    if (cycles < (uint64_t) 1 << (i + 6))
+      break;
+  buckets[i]++;
+}
+
+/* Prints the nonempty BUCKETS for operation WHAT. */
+static void
+print_buckets (const char *what, const int *buckets)
+{
+  int i;
+
+  msg ("%s cycles:", what);
+  for (i = 0; i < BUCKET_CNT; i++)
+    if (buckets[i] > 0)
+      {
+        if (i < BUCKET_CNT - 1)
+          msg ("  < %6d: %d", 1 << (i + 6), buckets[i]);
+        else
+          msg ("  >= %5d: %d", 1 << (i + 5), buckets[i]);
+      }
+}
@@ -0,0 +1,66 @@
+# -*- perl -*-
+
+# The expected output looks like this, with different counts:
+#
+# (palloc-stress) begin
+# (palloc-stress) 20000 operations, 0 failed allocations.
+# (palloc-stress) allocation cycles:
+# (palloc-stress)   <    512: 9630
+# (palloc-stress)   <   1024: 361
+# (palloc-stress)   >=  65536: 4
+# (palloc-stress) free cycles:
+# (palloc-stress)   <    256: 9978
+# (palloc-stress)   <    512: 27
+# (palloc-stress) PASS
+# (palloc-stress) end
+#
+# Only nonempty buckets are listed, in increasing order.  Every
+# operation is either an allocation or a free, so the buckets
+# must add up to the number of operations.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+
+fail "Missing begin line.\n" if shift (@output) ne '(palloc-stress) begin';
+fail "Missing end line.\n" if pop (@output) ne '(palloc-stress) end';
+fail "Missing PASS line.\n" if pop (@output) ne '(palloc-stress) PASS';
+
+my ($line) = shift (@output);
+my ($op_cnt, $failures)
+  = $line =~ /^\(palloc-stress\) (\d+) operations, (\d+) failed allocations\.$/
+  or fail "Malformed operation count: $line\n";
+fail "20000 operations expected but $op_cnt reported\n" if $op_cnt != 20000;
+
+my ($total) = 0;
+for my $what ('allocation', 'free') {
+    $line = shift (@output);
+    fail "Missing \"$what cycles:\" heading.\n"
+      if !defined ($line) || $line ne "(palloc-stress) $what cycles:";
+
+    my ($last_bound) = 0;
+    my ($last_cnt) = 0;
+    while (@output && $output[0] =~ /^\(palloc-stress\)   (<|>=) +(\d+): (\d+)$/) {
+	my ($op, $bound, $cnt) = ($1, $2, $3);
+	shift (@output);
+	fail "$what buckets out of order at $bound cycles\n"
+	  if $bound <= $last_bound && $op eq '<';
+	fail "Empty $what bucket at $bound cycles listed\n" if $cnt == 0;
+	$last_bound = $bound;
+	$last_cnt++;
+	$total += $cnt;
+    }
+    fail "No $what buckets listed.\n" if $last_cnt == 0;
+}
+fail "Unexpected output: $output[0]\n" if @output;
+fail "Buckets add up to $total operations instead of $op_cnt\n"
+  if $total != $op_cnt;
+
+pass;
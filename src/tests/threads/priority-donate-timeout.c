@@ -0,0 +1,87 @@
+/* The main thread acquires lock A.  A "medium" thread acquires
+   lock B and then blocks acquiring A, donating its priority to
+   the main thread.  A "high" thread then tries to acquire B with
+   a timeout, so that its priority reaches the main thread
+   through the medium thread.  The main thread sleeps past the
+   timeout without releasing A.  When the high thread gives up,
+   its donation must be withdrawn from the medium thread and the
+   main thread, which should be back at the medium thread's
+   priority. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Ticks the high thread waits for lock B. */
+#define TIMEOUT 10
+
+struct locks 
+  {
+    struct lock *a;
+    struct lock *b;
+  };
+
+static thread_func medium_thread_func;
+static thread_func high_thread_func;
+
+void
+test_priority_donate_timeout (void) 
+{
+  struct lock a, b;
+  struct locks locks;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  lock_init (&a);
+  lock_init (&b);
+  lock_acquire (&a);
+
+  locks.a = &a;
+  locks.b = &b;
+  thread_create ("medium", PRI_DEFAULT + 2, medium_thread_func, &locks);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+
+  thread_create ("high", PRI_DEFAULT + 4, high_thread_func, &b);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 4, thread_get_priority ());
+
+  timer_sleep (TIMEOUT * 2);
+  msg ("After the timeout, main thread should have priority %d.  "
+       "Actual priority: %d.", PRI_DEFAULT + 2, thread_get_priority ());
+
+  lock_release (&a);
+  msg ("Medium thread should just have finished.");
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+medium_thread_func (void *locks_) 
+{
+  struct locks *locks = locks_;
+
+  lock_acquire (locks->b);
+  lock_acquire (locks->a);
+  msg ("Medium thread got lock A.");
+  lock_release (locks->a);
+  lock_release (locks->b);
+  msg ("Medium thread finished.");
+}
+
+static void
+high_thread_func (void *lock_) 
+{
+  struct lock *lock = lock_;
+
+  if (lock_acquire_timeout (lock, TIMEOUT))
+    fail ("High thread acquired lock B, which is held throughout.");
+  msg ("High thread timed out waiting for lock B.");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-timeout) begin
+(priority-donate-timeout) Main thread should have priority 33.  Actual priority: 33.
+(priority-donate-timeout) Main thread should have priority 35.  Actual priority: 35.
+(priority-donate-timeout) High thread timed out waiting for lock B.
+(priority-donate-timeout) After the timeout, main thread should have priority 33.  Actual priority: 33.
+(priority-donate-timeout) Medium thread got lock A.
+(priority-donate-timeout) Medium thread finished.
+(priority-donate-timeout) Medium thread should just have finished.
+(priority-donate-timeout) Main thread should have priority 31.  Actual priority: 31.
+(priority-donate-timeout) end
+EOF
+pass;
@@ -0,0 +1,148 @@
+/* Measures how many reads several readers complete, alongside
+   one writer, when they share a struct lock and when they share
+   a struct rwlock.
+
+   Each reader holds the lock across a one-tick sleep, standing
+   in for a lookup that waits for the disk.  With a struct lock
+   the readers take turns, but with a struct rwlock they can all
+   wait at once, so they should complete several times as many
+   reads.  The writer writes every WRITE_INTERVAL ticks in both
+   cases. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of reader threads. */
+#define READER_CNT 4
+
+/* Length of each run, in timer ticks. */
+#define RUN_TICKS 200
+
+/* Ticks between writes. */
+#define WRITE_INTERVAL 10
+
+/* State shared by the threads in a run. */
+struct run
+  {
+    bool use_rwlock;            /* Use RWLOCK instead of LOCK? */
+    struct lock lock;
+    struct rwlock rwlock;
+    volatile bool stop;         /* Set when the run is over. */
+    int read_cnt;               /* Reads completed, protected by LOCK. */
+    int write_cnt;              /* Writes completed. */
+    struct semaphore done;      /* Upped by each thread as it exits. */
+  };
+
+static thread_func reader_thread, writer_thread;
+static void do_run (struct run *, bool use_rwlock);
+
+void
+test_rwlock_scale (void) 
+{
+  struct run lock_run, rwlock_run;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("%d readers and 1 writer, %d ticks per run.", READER_CNT, RUN_TICKS);
+  do_run (&lock_run, false);
+  msg ("struct lock: %d reads, %d writes.",
+       lock_run.read_cnt, lock_run.write_cnt);
+  do_run (&rwlock_run, true);
+  msg ("struct rwlock: %d reads, %d writes.",
+       rwlock_run.read_cnt, rwlock_run.write_cnt);
+
+  if (rwlock_run.write_cnt == 0)
+    fail ("writer starved by readers");
+  if (rwlock_run.read_cnt <= lock_run.read_cnt)
+    fail ("struct rwlock did not allow concurrent readers");
+  pass ();
+}
+
+/* Runs READER_CNT readers and one writer in R for RUN_TICKS
+   ticks. */
+static void
+do_run (struct run *r, bool use_rwlock) 
+{
+  int i;
+
+  r->use_rwlock = use_rwlock;
+  lock_init (&r->lock);
+  rwlock_init (&r->rwlock);
+  r->stop = false;
+  r->read_cnt = r->write_cnt = 0;
+  sema_init (&r->done, 0);
+
+  for (i = 0; i < READER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "reader %d", i);
+      thread_create (name, PRI_DEFAULT, reader_thread, r);
+    }
+  thread_create ("writer", PRI_DEFAULT, writer_thread, r);
+
+  timer_sleep (RUN_TICKS);
+  r->stop = true;
+  for (i = 0; i < READER_CNT + 1; i++)
+    sema_down (&r->done);
+}
+
+static void
+reader_thread (void *r_) 
+{
+  struct run *r = r_;
+
+  while (!r->stop) 
+    {
+      if (r->use_rwlock)
+        rwlock_acquire_read (&r->rwlock);
+      else
+        lock_acquire (&r->lock);
+
+      timer_sleep (1);
+
+      if (r->use_rwlock)
+        {
+          rwlock_release_read (&r->rwlock);
+          lock_acquire (&r->lock);
+          r->read_cnt++;
+          lock_release (&r->lock);
+        }
+      else
+        {
+          r->read_cnt++;
+          lock_release (&r->lock);
+        }
+    }
+  sema_up (&r->done);
+}
+
+static void
+writer_thread (void *r_) 
+{
+  struct run *r = r_;
+
+  while (!r->stop) 
+    {
+      timer_sleep (WRITE_INTERVAL);
+
+      if (r->use_rwlock)
+        rwlock_acquire_write (&r->rwlock);
+      else
+        lock_acquire (&r->lock);
+
+      timer_sleep (1);
+      r->write_cnt++;
+
+      if (r->use_rwlock)
+        rwlock_release_write (&r->rwlock);
+      else
+        lock_release (&r->lock);
+    }
+  sema_up (&r->done);
+}
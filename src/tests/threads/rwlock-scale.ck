@@ -0,0 +1,47 @@
+# -*- perl -*-
+
+# The expected output looks like this, with different counts:
+#
+# (rwlock-scale) begin
+# (rwlock-scale) 4 readers and 1 writer, 200 ticks per run.
+# (rwlock-scale) struct lock: 5321 reads, 1342 writes.
+# (rwlock-scale) struct rwlock: 21007 reads, 1205 writes.
+# (rwlock-scale) PASS
+# (rwlock-scale) end
+#
+# The readers must get further with the rwlock than with the
+# lock, and the writer must not be starved by them.
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "6 lines of output expected but " . scalar (@output) . " found\n"
+  if @output != 6;
+
+fail "Missing begin line.\n" if $output[0] ne '(rwlock-scale) begin';
+fail "Missing run description.\n"
+  if $output[1] ne '(rwlock-scale) 4 readers and 1 writer, 200 ticks per run.';
+
+my ($lock_reads, $lock_writes)
+  = $output[2] =~ /^\(rwlock-scale\) struct lock: (\d+) reads, (\d+) writes\.$/
+  or fail "Malformed struct lock result: $output[2]\n";
+my ($rwlock_reads, $rwlock_writes)
+  = $output[3] =~ /^\(rwlock-scale\) struct rwlock: (\d+) reads, (\d+) writes\.$/
+  or fail "Malformed struct rwlock result: $output[3]\n";
+
+fail "Readers got no further with the rwlock ($rwlock_reads reads) "
+  . "than with the lock ($lock_reads reads).\n"
+  if $rwlock_reads <= $lock_reads;
+fail "Writer was starved under the rwlock.\n" if $rwlock_writes == 0;
+
+fail "Missing PASS line.\n" if $output[4] ne '(rwlock-scale) PASS';
+fail "Missing end line.\n" if $output[5] ne '(rwlock-scale) end';
+
+pass;
@@ -0,0 +1,66 @@
+/* Checks sema_down_timeout().  Waiting on a semaphore that stays
+   at 0 must give up after the given number of ticks and leave the
+   semaphore as it was, without the timed-out thread on its
+   waiters list to swallow a later "up".  Waiting on a semaphore
+   that another thread ups in time must succeed as soon as it is
+   upped. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Ticks to wait for a semaphore that is never upped. */
+#define TIMEOUT 10
+
+/* Ticks after which the "up" thread ups the semaphore. */
+#define UP_DELAY 5
+
+static thread_func up_thread_func;
+
+void
+test_sema_timeout (void) 
+{
+  struct semaphore sema;
+  int64_t start_time;
+
+  sema_init (&sema, 0);
+
+  if (sema_down_timeout (&sema, 0))
+    fail ("sema_down_timeout() with 0 ticks downed a 0 semaphore.");
+  msg ("Waiting 0 ticks failed without blocking.");
+
+  start_time = timer_ticks ();
+  if (sema_down_timeout (&sema, TIMEOUT))
+    fail ("sema_down_timeout() downed a 0 semaphore.");
+  if (timer_elapsed (start_time) < TIMEOUT)
+    fail ("sema_down_timeout() gave up after only %"PRId64" ticks.",
+          timer_elapsed (start_time));
+  msg ("Waiting %d ticks timed out.", TIMEOUT);
+
+  sema_up (&sema);
+  if (!sema_try_down (&sema))
+    fail ("\"Up\" after the timeout was lost.");
+  msg ("\"Up\" after the timeout was kept.");
+
+  thread_create ("up", PRI_DEFAULT - 1, up_thread_func, &sema);
+  start_time = timer_ticks ();
+  if (!sema_down_timeout (&sema, TIMEOUT * 100))
+    fail ("sema_down_timeout() timed out on an upped semaphore.");
+  if (timer_elapsed (start_time) >= TIMEOUT * 100)
+    fail ("sema_down_timeout() returned only after its timeout.");
+  msg ("Waiting for the \"up\" thread succeeded.");
+}
+
+static void
+up_thread_func (void *sema_) 
+{
+  struct semaphore *sema = sema_;
+
+  timer_sleep (UP_DELAY);
+  msg ("Upping the semaphore.");
+  sema_up (sema);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sema-timeout) begin
+(sema-timeout) Waiting 0 ticks failed without blocking.
+(sema-timeout) Waiting 10 ticks timed out.
+(sema-timeout) "Up" after the timeout was kept.
+(sema-timeout) Upping the semaphore.
+(sema-timeout) Waiting for the "up" thread succeeded.
+(sema-timeout) end
+EOF
+pass;
@@ -26,12 +26,19 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-timeout", test_priority_donate_timeout},
     {"priority-fifo", test_priority_fifo},
     {"priority-lifo", test_priority_lifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-aging", test_priority_aging},
     {"priority-condvar", test_priority_condvar},
+    {"sema-timeout", test_sema_timeout},
+    {"rwlock-scale", test_rwlock_scale},
+    {"mutex-bench", test_mutex_bench},
+    {"thread-create-bench", test_thread_create_bench},
+    {"palloc-stress", test_palloc_stress},
+    {"workqueue", test_workqueue},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -20,12 +20,19 @@ extern test_func test_priority_donate_sema;
 extern test_func test_priority_donate_nest;
 extern test_func test_priority_donate_lower;
 extern test_func test_priority_donate_chain;
+extern test_func test_priority_donate_timeout;
 extern test_func test_priority_fifo;
 extern test_func test_priority_lifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_aging;
 extern test_func test_priority_condvar;
+extern test_func test_sema_timeout;
+extern test_func test_rwlock_scale;
+extern test_func test_mutex_bench;
+extern test_func test_thread_create_bench;
+extern test_func test_palloc_stress;
+extern test_func test_workqueue;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -0,0 +1,59 @@
+/* Measures the cost, in CPU cycles, of creating a short-lived
+   thread and waiting for it to exit, as when spawning a worker
+   for a small piece of work.
+
+   Each thread is created at a higher priority than the main
+   thread, so it runs, signals, and exits before thread_create()
+   returns.  Its page is reclaimed when the main thread runs
+   again. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+
+/* Number of threads to create in each round. */
+#define THREAD_CNT 500
+
+/* Number of rounds. */
+#define ROUND_CNT 3
+
+static thread_func worker_thread;
+
+void
+test_thread_create_bench (void) 
+{
+  struct semaphore done;
+  int round;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&done, 0);
+  for (round = 0; round < ROUND_CNT; round++)
+    {
+      uint64_t start = rdtsc ();
+      int i;
+
+      for (i = 0; i < THREAD_CNT; i++)
+        {
+          if (thread_create ("worker", PRI_DEFAULT + 1, worker_thread, &done)
+              == TID_ERROR)
+            fail ("thread_create() failed");
+          sema_down (&done);
+        }
+      msg ("round %d: %d cycles per create and join.",
+           round, (int) ((rdtsc () - start) / THREAD_CNT));
+    }
+  pass ();
+}
+
+static void
+worker_thread (void *done_) 
+{
+  struct semaphore *done = done_;
+
+  sema_up (done);
+}
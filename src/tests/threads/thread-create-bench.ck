@@ -0,0 +1,35 @@
+# -*- perl -*-
+
+# The expected output looks like this, with different cycle
+# counts:
+#
+# (thread-create-bench) begin
+# (thread-create-bench) round 0: 18211 cycles per create and join.
+# (thread-create-bench) round 1: 17764 cycles per create and join.
+# (thread-create-bench) round 2: 17790 cycles per create and join.
+# (thread-create-bench) PASS
+# (thread-create-bench) end
+
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "6 lines of output expected but " . scalar (@output) . " found\n"
+  if @output != 6;
+
+fail "Missing begin line.\n" if $output[0] ne '(thread-create-bench) begin';
+for my $round (0...2) {
+    my ($line) = $output[$round + 1];
+    fail "Malformed result for round $round: $line\n"
+      if $line !~ /^\(thread-create-bench\) round $round: \d+ cycles per create and join\.$/;
+}
+fail "Missing PASS line.\n" if $output[4] ne '(thread-create-bench) PASS';
+fail "Missing end line.\n" if $output[5] ne '(thread-create-bench) end';
+
+pass;
@@ -0,0 +1,83 @@
+/* Checks that a work queue runs submitted work items in order,
+   ignores duplicate submissions, honors cancellation, and runs
+   delayed work items in order of their delays.
+
+   The queue's single worker runs at a lower priority than the
+   main thread, so that submitted items stay queued until the
+   main thread waits for them. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+/* Number of work items. */
+#define WORK_CNT 5
+
+/* Record of the work items that have run, in order. */
+static int ran[WORK_CNT * 2];
+static int ran_cnt;
+
+static work_func record_work;
+
+static void
+print_ran (const char *what)
+{
+  char buf[64];
+  int ofs = 0;
+  int i;
+
+  for (i = 0; i < ran_cnt; i++)
+    ofs += snprintf (buf + ofs, sizeof buf - ofs, " %d", ran[i]);
+  buf[ofs] = '\0';
+  msg ("%s:%s", what, buf);
+  ran_cnt = 0;
+}
+
+void
+test_workqueue (void)
+{
+  static struct workqueue wq;
+  struct work work[WORK_CNT];
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  if (!workqueue_init (&wq, "test-wq", 1, PRI_DEFAULT - 1))
+    fail ("workqueue_init() failed");
+  for (i = 0; i < WORK_CNT; i++)
+    work_init (&work[i], record_work, (void *) i);
+
+  msg ("Submitting %d work items.", WORK_CNT);
+  for (i = 0; i < WORK_CNT; i++)
+    if (!work_submit (&wq, &work[i]))
+      fail ("work_submit() of idle item %d failed", i);
+  if (work_submit (&wq, &work[0]))
+    fail ("work_submit() of queued item succeeded");
+  if (!work_cancel (&work[2]))
+    fail ("work_cancel() of queued item failed");
+  if (work_cancel (&work[2]))
+    fail ("work_cancel() of canceled item succeeded");
+  workqueue_flush (&wq);
+  print_ran ("Ran in order, without item 2");
+
+  msg ("Submitting delayed work items.");
+  work_submit_delayed (&wq, &work[0], 30);
+  work_submit_delayed (&wq, &work[1], 10);
+  work_submit_delayed (&wq, &work[2], 20);
+  work_submit_delayed (&wq, &work[3], 40);
+  if (!work_cancel (&work[3]))
+    fail ("work_cancel() of delayed item failed");
+  timer_sleep (50);
+  workqueue_flush (&wq);
+  print_ran ("Ran in order of delay, without item 3");
+}
+
+static void
+record_work (void *i_)
+{
+  ran[ran_cnt++] = (int) i_;
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) Submitting 5 work items.
+(workqueue) Ran in order, without item 2: 0 1 3 4
+(workqueue) Submitting delayed work items.
+(workqueue) Ran in order of delay, without item 3: 1 2 0
+(workqueue) end
+EOF
+pass;
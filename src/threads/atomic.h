@@ -0,0 +1,56 @@
+#ifndef THREADS_ATOMIC_H
+#define THREADS_ATOMIC_H
+
+#include <stdint.h>
+
+/* Atomic operations on 32-bit words in memory.
+
+   Each one is a single locked instruction, so it is atomic with
+   respect to interrupts and to other CPUs, and it is also a
+   compiler barrier.  See [IA32-v2a] "CMPXCHG" and "XCHG" and
+   [IA32-v2b] "XADD". */
+
+/* If *P equals OLD, sets *P to NEW.  Either way, returns the
+   value that *P held before. */
+static inline uint32_t
+atomic_cmpxchg (volatile uint32_t *p, uint32_t old, uint32_t new)
+{
+  uint32_t prev;
+  asm volatile ("lock cmpxchgl %2, %1"
+                : "=a" (prev), "+m" (*p)
+                : "r" (new), "0" (old)
+                : "memory");
+  return prev;
+}
+
+/* Sets *P to NEW and returns the value that *P held before. */
+static inline uint32_t
+atomic_xchg (volatile uint32_t *p, uint32_t new)
+{
+  asm volatile ("xchgl %0, %1"
+                : "+r" (new), "+m" (*p)
+                :
+                : "memory");
+  return new;
+}
+
+/* Adds N to *P and returns the value that *P held before. */
+static inline uint32_t
+atomic_fetch_add (volatile uint32_t *p, uint32_t n)
+{
+  asm volatile ("lock xaddl %0, %1"
+                : "+r" (n), "+m" (*p)
+                :
+                : "memory");
+  return n;
+}
+
+/* Tells the CPU that we are in a spin-wait loop.  See
+   [IA32-v2b] "PAUSE". */
+static inline void
+cpu_relax (void)
+{
+  asm volatile ("pause" : : : "memory");
+}
+
+#endif /* threads/atomic.h */
@@ -20,8 +20,11 @@
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/pte.h"
+#include "threads/smp.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -96,6 +99,8 @@ main (void)
 
   /* Initialize memory system. */
   palloc_init (user_page_limit);
+  trace_init ();
+  profile_init ();
   malloc_init ();
   paging_init ();
 
@@ -117,8 +122,10 @@ main (void)
 
   /* Start thread scheduler and enable interrupts. */
   thread_start ();
+  softirq_start ();
   serial_init_queue ();
   timer_calibrate ();
+  smp_init ();
 
 #ifdef FILESYS
   /* Initialize file system. */
@@ -258,9 +265,35 @@ parse_options (char **argv)
         thread_mlfqs = true;
       else if (!strcmp (name, "-aging"))
         thread_prior_aging = true;
+      else if (!strcmp (name, "-trace"))
+        {
+          if (value == NULL || !strcmp (value, "serial"))
+            trace_configure (TRACE_SERIAL);
+          else if (!strcmp (value, "scratch"))
+            trace_configure (TRACE_SCRATCH);
+          else
+            PANIC ("unknown trace sink `%s' (use -h for help)", value);
+        }
+      else if (!strcmp (name, "-mempty"))
+        malloc_empty_arenas = atoi (value);
+      else if (!strcmp (name, "-mpoison"))
+        malloc_poison = true;
+      else if (!strcmp (name, "-smp"))
+        smp_configure ();
+      else if (!strcmp (name, "-istats"))
+        intr_off_stats = true;
+      else if (!strcmp (name, "-profile"))
+        {
+          int divisor = value != NULL ? atoi (value) : 1;
+          if (divisor <= 0)
+            PANIC ("bad profile divisor `%s' (use -h for help)", value);
+          profile_configure (divisor);
+        }
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+      else if (!strcmp (name, "-sstats"))
+        syscall_stats_on_exit = true;
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -381,8 +414,16 @@ usage (void)
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -trace[=SINK]      Trace kernel events, dump to SINK at power off.\n"
+          "                     SINK is serial (default) or scratch.\n"
+          "  -profile[=N]       Sample the running code every N timer ticks.\n"
+          "  -smp               Start the other CPUs, which then halt.\n"
+          "  -istats            Time the longest stretch with interrupts off.\n"
+          "  -mempty=N          Keep N empty malloc arenas per size (default 1).\n"
+          "  -mpoison           Fill freed malloc and slab objects with 0xcc.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+          "  -sstats            Print system call totals at process exit.\n"
 #endif
           );
   shutdown_power_off ();
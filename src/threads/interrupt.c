@@ -6,7 +6,10 @@
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/tsc.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
 
@@ -47,6 +50,45 @@ static unsigned int unexpected_cnt[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Softirqs: work deferred by external interrupt handlers, run
+   with interrupts on just before the interrupt returns.  Softirqs
+   never nest, nor are they pre-empted: an interrupt that arrives
+   while one runs leaves any softirqs it raises, and any yield it
+   requests, to the outermost handler.  Like external interrupt
+   handlers, softirqs may not sleep. */
+static softirq_func *softirq_handlers[SOFTIRQ_CNT];
+static const char *softirq_names[SOFTIRQ_CNT];
+static uint64_t softirq_runs[SOFTIRQ_CNT];  /* Times each one ran. */
+static unsigned softirq_pending;  /* Bitmap of raised softirqs. */
+static bool in_softirq;           /* Are we running softirqs? */
+static bool in_ksoftirqd;         /* In ksoftirqd, not on return? */
+
+/* Number of times to rerun softirqs raised while softirqs were
+   running before handing them off to ksoftirqd, so that an
+   interrupt storm cannot starve the interrupted thread. */
+#define SOFTIRQ_RESTART_MAX 10
+
+/* Thread that runs softirqs handed off by interrupt handlers. */
+static struct thread *ksoftirqd_thread;
+static struct semaphore ksoftirqd_wakeup;
+static uint64_t ksoftirqd_runs;
+
+/* Measure how long interrupts stay off?
+   Controlled by kernel command-line option "-istats". */
+bool intr_off_stats;
+
+/* Longest stretch with interrupts off, in TSC cycles, measured
+   from the time interrupts were turned off, either by
+   intr_disable() or intr_set_level() or by the CPU on entry to
+   an interrupt gate, until they were next turned back on.
+   INTR_OFF_SITE is the code that turned them off: the caller of
+   intr_disable() or intr_set_level(), or the interrupt
+   handler. */
+static uint64_t intr_off_tsc;           /* When turned off, or 0. */
+static const void *intr_off_site;
+static uint64_t intr_off_max;
+static const void *intr_off_max_site;
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -59,6 +101,12 @@ static inline uint64_t make_idtr_operand (uint16_t limit, void *base);
 /* Interrupt handlers. */
 void intr_handler (struct intr_frame *args);
 static void unexpected_interrupt (const struct intr_frame *);
+
+static void run_softirqs (void);
+static thread_func ksoftirqd NO_RETURN;
+static enum intr_level disable (const void *site);
+static void intr_off_begin (const void *site);
+static void intr_off_end (void);
 
 /* Returns the current interrupt status. */
 enum intr_level
@@ -80,7 +128,9 @@ intr_get_level (void)
 enum intr_level
 intr_set_level (enum intr_level level) 
 {
-  return level == INTR_ON ? intr_enable () : intr_disable ();
+  return (level == INTR_ON
+          ? intr_enable ()
+          : disable (__builtin_return_address (0)));
 }
 
 /* Enables interrupts and returns the previous interrupt status. */
@@ -94,6 +144,8 @@ intr_enable (void)
 
      See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
      Hardware Interrupts". */
+  if (old_level == INTR_OFF)
+    intr_off_end ();
   asm volatile ("sti");
 
   return old_level;
@@ -102,6 +154,14 @@ intr_enable (void)
 /* Disables interrupts and returns the previous interrupt status. */
 enum intr_level
 intr_disable (void) 
+{
+  return disable (__builtin_return_address (0));
+}
+
+/* Disables interrupts on behalf of the code at SITE and returns
+   the previous interrupt status. */
+static enum intr_level
+disable (const void *site) 
 {
   enum intr_level old_level = intr_get_level ();
 
@@ -109,6 +169,8 @@ intr_disable (void)
      See [IA32-v2b] "CLI" and [IA32-v3a] 5.8.1 "Masking Maskable
      Hardware Interrupts". */
   asm volatile ("cli" : : : "memory");
+  if (old_level == INTR_ON)
+    intr_off_begin (site);
 
   return old_level;
 }
@@ -214,16 +276,80 @@ intr_context (void)
   return in_external_intr;
 }
 
-/* During processing of an external interrupt, directs the
-   interrupt handler to yield to a new process just before
-   returning from the interrupt.  May not be called at any other
-   time. */
+/* During processing of an external interrupt or a softirq,
+   directs the interrupt handler to yield to a new process just
+   before returning from the interrupt.  May not be called at any
+   other time. */
 void
 intr_yield_on_return (void) 
 {
-  ASSERT (intr_context ());
+  ASSERT (intr_context () || softirq_context ());
   yield_on_return = true;
 }
+
+/* Registers FUNC to be called for softirq NR, which is named
+   NAME for debugging purposes. */
+void
+softirq_register (enum softirq nr, softirq_func *func, const char *name)
+{
+  ASSERT (nr < SOFTIRQ_CNT);
+  ASSERT (softirq_handlers[nr] == NULL);
+
+  softirq_handlers[nr] = func;
+  softirq_names[nr] = name;
+}
+
+/* Arranges for softirq NR to run once the external interrupt
+   being handled returns.  Must be called with interrupts off,
+   normally from an external interrupt handler. */
+void
+softirq_raise (enum softirq nr)
+{
+  ASSERT (nr < SOFTIRQ_CNT);
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  softirq_pending |= 1u << nr;
+}
+
+/* Returns true while softirqs are running, false otherwise. */
+bool
+softirq_context (void) 
+{
+  return in_softirq;
+}
+
+/* Returns true if softirqs are running in ksoftirqd, rather than
+   on return from the interrupt that raised them, false
+   otherwise. */
+bool
+softirq_in_ksoftirqd (void) 
+{
+  return in_ksoftirqd;
+}
+
+/* Starts the ksoftirqd thread, which runs softirqs that are
+   raised faster than interrupt returns can keep up with. */
+void
+softirq_start (void) 
+{
+  sema_init (&ksoftirqd_wakeup, 0);
+  thread_create ("ksoftirqd", PRI_MAX, ksoftirqd, NULL);
+}
+
+/* Prints interrupt statistics. */
+void
+intr_print_stats (void) 
+{
+  int i;
+
+  if (intr_off_stats)
+    printf ("Interrupts: %"PRIu64" cycles max with interrupts off, "
+            "from %p\n", intr_off_max, intr_off_max_site);
+  for (i = 0; i < SOFTIRQ_CNT; i++)
+    if (softirq_handlers[i] != NULL)
+      printf ("Softirq %s: %"PRIu64" runs\n", softirq_names[i], softirq_runs[i]);
+  printf ("Softirq: %"PRIu64" handed off to ksoftirqd\n", ksoftirqd_runs);
+}
 
 /* 8259A Programmable Interrupt Controller. */
 
@@ -347,6 +473,8 @@ intr_handler (struct intr_frame *frame)
   bool external;
   intr_handler_func *handler;
 
+  TRACE (TRACE_INTR_ENTER, frame->vec_no);
+
   /* External interrupts are special.
      We only handle one at a time (so interrupts must be off)
      and they need to be acknowledged on the PIC (see below).
@@ -358,8 +486,9 @@ intr_handler (struct intr_frame *frame)
       ASSERT (!intr_context ());
 
       in_external_intr = true;
-      yield_on_return = false;
     }
+  if (intr_get_level () == INTR_OFF && (frame->eflags & FLAG_IF))
+    intr_off_begin ((const void *) intr_handlers[frame->vec_no]);
 
   /* Invoke the interrupt's handler. */
   handler = intr_handlers[frame->vec_no];
@@ -374,6 +503,8 @@ intr_handler (struct intr_frame *frame)
   else
     unexpected_interrupt (frame);
 
+  TRACE (TRACE_INTR_EXIT, frame->vec_no);
+
   /* Complete the processing of an external interrupt. */
   if (external) 
     {
@@ -383,8 +514,110 @@ intr_handler (struct intr_frame *frame)
       in_external_intr = false;
       pic_end_of_interrupt (frame->vec_no); 
 
+      if (!in_softirq)
+        {
+          if (softirq_pending != 0)
+            run_softirqs ();
+          if (yield_on_return) 
+            {
+              yield_on_return = false;
+              thread_yield (); 
+            }
+        }
+    }
+  if (intr_get_level () == INTR_OFF && (frame->eflags & FLAG_IF))
+    intr_off_end ();
+}
+
+/* Runs pending softirqs with interrupts on, until none are
+   pending.  If softirqs keep being raised, hands them off to
+   ksoftirqd instead.  Must be called with interrupts off, and
+   returns with interrupts off. */
+static void
+run_softirqs (void) 
+{
+  int restarts;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (!in_softirq);
+
+  in_softirq = true;
+  for (restarts = 0; softirq_pending != 0; restarts++)
+    {
+      unsigned pending = softirq_pending;
+      int i;
+
+      if (restarts >= SOFTIRQ_RESTART_MAX && ksoftirqd_thread != NULL)
+        break;
+
+      softirq_pending = 0;
+      intr_enable ();
+      for (i = 0; i < SOFTIRQ_CNT; i++)
+        if (pending & (1u << i))
+          {
+            softirq_runs[i]++;
+            softirq_handlers[i] ();
+          }
+      intr_disable ();
+    }
+  in_softirq = false;
+
+  if (softirq_pending != 0)
+    {
+      ksoftirqd_runs++;
+      sema_up (&ksoftirqd_wakeup);
+    }
+}
+
+/* ksoftirqd thread: runs softirqs handed off by run_softirqs(). */
+static void
+ksoftirqd (void *aux UNUSED) 
+{
+  ksoftirqd_thread = thread_current ();
+  for (;;) 
+    {
+      sema_down (&ksoftirqd_wakeup);
+
+      intr_disable ();
+      if (softirq_pending != 0)
+        {
+          in_ksoftirqd = true;
+          run_softirqs ();
+          in_ksoftirqd = false;
+        }
       if (yield_on_return) 
-        thread_yield (); 
+        {
+          yield_on_return = false;
+          thread_yield (); 
+        }
+      intr_enable ();
+    }
+}
+
+/* Notes that interrupts were just turned off by SITE. */
+static void
+intr_off_begin (const void *site) 
+{
+  if (intr_off_stats)
+    {
+      intr_off_tsc = rdtsc ();
+      intr_off_site = site;
+    }
+}
+
+/* Notes that interrupts are about to be turned back on. */
+static void
+intr_off_end (void) 
+{
+  if (intr_off_tsc != 0)
+    {
+      uint64_t cycles = rdtsc () - intr_off_tsc;
+      if (cycles > intr_off_max)
+        {
+          intr_off_max = cycles;
+          intr_off_max_site = intr_off_site;
+        }
+      intr_off_tsc = 0;
     }
 }
 
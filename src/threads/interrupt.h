@@ -11,6 +11,10 @@ enum intr_level
     INTR_ON               /* Interrupts enabled. */
   };
 
+/* Measure how long interrupts stay off?
+   Controlled by kernel command-line option "-istats". */
+extern bool intr_off_stats;
+
 enum intr_level intr_get_level (void);
 enum intr_level intr_set_level (enum intr_level);
 enum intr_level intr_enable (void);
@@ -63,6 +67,24 @@ void intr_register_int (uint8_t vec, int dpl, enum intr_level,
                         intr_handler_func *, const char *name);
 bool intr_context (void);
 void intr_yield_on_return (void);
+void intr_print_stats (void);
+
+/* Softirqs, in the order they run. */
+enum softirq
+  {
+    SOFTIRQ_TIMER,              /* Scheduler bookkeeping for timer ticks. */
+    SOFTIRQ_BLOCK,              /* Block device completions. */
+    SOFTIRQ_SERIAL,             /* Serial port transmit wakeups. */
+    SOFTIRQ_CNT                 /* Number of softirqs. */
+  };
+
+typedef void softirq_func (void);
+
+void softirq_register (enum softirq, softirq_func *, const char *name);
+void softirq_raise (enum softirq);
+bool softirq_context (void);
+bool softirq_in_ksoftirqd (void);
+void softirq_start (void);
 
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
@@ -5,17 +5,21 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
+   The size of each request, in bytes, is rounded up to the
+   nearest size class and assigned to the "descriptor" that
+   manages blocks of that size.  The classes are powers of 2 up
+   to 512 bytes; above that, they are the largest sizes that
+   pack 4, 3, or 2 blocks into a page, so that a 1.5 kB request
+   does not take a whole page.  The descriptor keeps a list of
+   free blocks.  If the free list is nonempty, one of its blocks
+   is used to satisfy the request.
 
    Otherwise, a new page of memory, called an "arena", is
    obtained from the page allocator (if none is available,
@@ -25,14 +29,32 @@
 
    When we free a block, we add it to its descriptor's free list.
    But if the arena that the block was in now has no in-use
-   blocks, we remove all of the arena's blocks from the free list
-   and give the arena back to the page allocator.
-
-   We can't handle blocks bigger than 2 kB using this scheme,
+   blocks, and the descriptor already keeps enough such empty
+   arenas, we remove all of the arena's blocks from the free list
+   and give the arena back to the page allocator.  Keeping a few
+   empty arenas spares a loop that allocates and frees right at
+   an arena boundary from getting and freeing a page each time.
+
+   In front of each descriptor's free list and lock sits a
+   "magazine", a small stack of free blocks.  malloc() and free()
+   take a block from and return a block to the magazine with
+   interrupts off, taking the lock only to refill or drain half
+   of the magazine at a time.  Blocks in a magazine count as in
+   use in their arenas.
+
+   We can't handle blocks bigger than about 2 kB using this scheme,
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   realloc() leaves a block where it is when it can: a small
+   block whose new size falls in the same size class, and a big
+   block whose page count stays the same, shrinks (freeing its
+   tail pages), or grows into free pages right after it. */
+
+/* Number of blocks in a magazine. */
+#define MAGAZINE_SIZE 16
 
 /* Descriptor. */
 struct desc
@@ -41,6 +63,11 @@ struct desc
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
     struct list free_list;      /* List of free blocks. */
     struct lock lock;           /* Lock. */
+    size_t empty_cnt;           /* Arenas with no blocks in use. */
+
+    /* Access with interrupts off. */
+    struct block *magazine[MAGAZINE_SIZE]; /* Cached free blocks. */
+    size_t magazine_cnt;        /* Number of blocks in MAGAZINE. */
   };
 
 /* Magic number for detecting arena corruption. */
@@ -64,24 +91,65 @@ struct block
 static struct desc descs[10];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Number of empty arenas each descriptor keeps, rather than
+   freeing them.  Set by the "-mempty" kernel option. */
+unsigned malloc_empty_arenas = 1;
+
+/* If true, free() and kmem_cache_free() fill freed blocks with
+   0xcc to help detect use-after-free bugs.  Set by the
+   "-mpoison" kernel option. */
+bool malloc_poison;
+
+static void add_desc (size_t block_size);
+static struct desc *size_to_desc (size_t);
+static bool resize_in_place (void *block, size_t new_size);
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct block *get_block (struct desc *);
+static void put_block (struct desc *, struct block *);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) 
 {
   size_t block_size;
+  size_t n;
 
-  for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2)
-    {
-      struct desc *d = &descs[desc_cnt++];
-      ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
-      d->block_size = block_size;
-      d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-      list_init (&d->free_list);
-      lock_init (&d->lock);
-    }
+  for (block_size = 16; block_size <= PGSIZE / 8; block_size *= 2)
+    add_desc (block_size);
+  for (n = 4; n >= 2; n--)
+    add_desc (ROUND_DOWN ((PGSIZE - sizeof (struct arena)) / n, 8));
+}
+
+/* Adds a descriptor for blocks of BLOCK_SIZE bytes, which must
+   be larger than those of any existing descriptor. */
+static void
+add_desc (size_t block_size) 
+{
+  struct desc *d = &descs[desc_cnt++];
+
+  ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
+  ASSERT (d == descs || d[-1].block_size < block_size);
+  d->block_size = block_size;
+  d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+  list_init (&d->free_list);
+  lock_init_named (&d->lock, "malloc");
+  d->empty_cnt = 0;
+  d->magazine_cnt = 0;
+}
+
+/* Returns the smallest descriptor that satisfies a SIZE-byte
+   request, or a null pointer if SIZE is too big for any
+   descriptor. */
+static struct desc *
+size_to_desc (size_t size) 
+{
+  struct desc *d;
+
+  for (d = descs; d < descs + desc_cnt; d++)
+    if (d->block_size >= size)
+      return d;
+  return NULL;
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -92,17 +160,14 @@ malloc (size_t size)
   struct desc *d;
   struct block *b;
   struct arena *a;
+  enum intr_level old_level;
 
   /* A null pointer satisfies a request for 0 bytes. */
   if (size == 0)
     return NULL;
 
-  /* Find the smallest descriptor that satisfies a SIZE-byte
-     request. */
-  for (d = descs; d < descs + desc_cnt; d++)
-    if (d->block_size >= size)
-      break;
-  if (d == descs + desc_cnt) 
+  d = size_to_desc (size);
+  if (d == NULL) 
     {
       /* SIZE is too big for any descriptor.
          Allocate enough pages to hold SIZE plus an arena. */
@@ -119,36 +184,41 @@ malloc (size_t size)
       return a + 1;
     }
 
-  lock_acquire (&d->lock);
-
-  /* If the free list is empty, create a new arena. */
-  if (list_empty (&d->free_list))
+  /* Take a block from the magazine, if it has one. */
+  old_level = intr_disable ();
+  if (d->magazine_cnt > 0)
     {
-      size_t i;
-
-      /* Allocate a page. */
-      a = palloc_get_page (0);
-      if (a == NULL) 
-        {
-          lock_release (&d->lock);
-          return NULL; 
-        }
-
-      /* Initialize arena and add its blocks to the free list. */
-      a->magic = ARENA_MAGIC;
-      a->desc = d;
-      a->free_cnt = d->blocks_per_arena;
-      for (i = 0; i < d->blocks_per_arena; i++) 
-        {
-          struct block *b = arena_to_block (a, i);
-          list_push_back (&d->free_list, &b->free_elem);
-        }
+      b = d->magazine[--d->magazine_cnt];
+      intr_set_level (old_level);
+      return b;
     }
+  intr_set_level (old_level);
 
-  /* Get a block from free list and return it. */
-  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
-  a->free_cnt--;
+  /* Otherwise, take a block from the free list for ourselves,
+     and refill half of the magazine while we hold the lock. */
+  lock_acquire (&d->lock);
+  b = get_block (d);
+  if (b != NULL)
+    {
+      struct block *refill[MAGAZINE_SIZE / 2];
+      size_t refill_cnt, i;
+
+      refill_cnt = 0;
+      while (refill_cnt < MAGAZINE_SIZE / 2 && !list_empty (&d->free_list))
+        refill[refill_cnt++] = get_block (d);
+
+      old_level = intr_disable ();
+      for (i = 0; i < refill_cnt; i++)
+        if (d->magazine_cnt < MAGAZINE_SIZE)
+          d->magazine[d->magazine_cnt++] = refill[i];
+        else
+          break;
+      intr_set_level (old_level);
+
+      /* The magazine filled up behind our back: return the rest. */
+      for (; i < refill_cnt; i++)
+        put_block (d, refill[i]);
+    }
   lock_release (&d->lock);
   return b;
 }
@@ -199,6 +269,8 @@ realloc (void *old_block, size_t new_size)
       free (old_block);
       return NULL;
     }
+  else if (old_block != NULL && resize_in_place (old_block, new_size))
+    return old_block;
   else 
     {
       void *new_block = malloc (new_size);
@@ -213,6 +285,35 @@ realloc (void *old_block, size_t new_size)
     }
 }
 
+/* Tries to resize BLOCK to NEW_SIZE bytes without moving it.
+   Returns true if successful, false if BLOCK must move. */
+static bool
+resize_in_place (void *block, size_t new_size) 
+{
+  struct arena *a = block_to_arena (block);
+  struct desc *d = size_to_desc (new_size);
+  size_t old_cnt, new_cnt;
+
+  /* A small block stays put if its size class does not change.
+     A block moving between a size class and whole pages must
+     move, too. */
+  if (a->desc != NULL || d != NULL)
+    return a->desc == d;
+
+  /* A big block frees its tail pages when it shrinks, and grows
+     into the pages after it if they are free. */
+  old_cnt = a->free_cnt;
+  new_cnt = DIV_ROUND_UP (new_size + sizeof *a, PGSIZE);
+  if (new_cnt < old_cnt)
+    palloc_free_multiple ((uint8_t *) a + new_cnt * PGSIZE,
+                          old_cnt - new_cnt);
+  else if (new_cnt > old_cnt
+           && !palloc_extend (a, old_cnt, new_cnt - old_cnt))
+    return false;
+  a->free_cnt = new_cnt;
+  return true;
+}
+
 /* Frees block P, which must have been previously allocated with
    malloc(), calloc(), or realloc(). */
 void
@@ -227,31 +328,33 @@ free (void *p)
       if (d != NULL) 
         {
           /* It's a normal block.  We handle it here. */
+          struct block *drain[MAGAZINE_SIZE / 2];
+          size_t drain_cnt, i;
+          enum intr_level old_level;
 
-#ifndef NDEBUG
           /* Clear the block to help detect use-after-free bugs. */
-          memset (b, 0xcc, d->block_size);
-#endif
-  
-          lock_acquire (&d->lock);
-
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
+          if (malloc_poison)
+            memset (b, 0xcc, d->block_size);
 
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
+          /* Put the block in the magazine, if it has room. */
+          old_level = intr_disable ();
+          if (d->magazine_cnt < MAGAZINE_SIZE)
             {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
+              d->magazine[d->magazine_cnt++] = b;
+              intr_set_level (old_level);
+              return;
             }
 
+          /* Otherwise, drain half of the magazine, along with the
+             block, to the free list. */
+          for (drain_cnt = 0; drain_cnt < MAGAZINE_SIZE / 2; drain_cnt++)
+            drain[drain_cnt] = d->magazine[--d->magazine_cnt];
+          intr_set_level (old_level);
+
+          lock_acquire (&d->lock);
+          put_block (d, b);
+          for (i = 0; i < drain_cnt; i++)
+            put_block (d, drain[i]);
           lock_release (&d->lock);
         }
       else
@@ -263,6 +366,81 @@ free (void *p)
     }
 }
 
+/* Removes a block from D's free list, first creating a new
+   arena if the list is empty, and returns it.  Returns a null
+   pointer if memory is not available.  D's lock must be held. */
+static struct block *
+get_block (struct desc *d) 
+{
+  struct block *b;
+  struct arena *a;
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  /* If the free list is empty, create a new arena. */
+  if (list_empty (&d->free_list))
+    {
+      size_t i;
+
+      /* Allocate a page. */
+      a = palloc_get_page (0);
+      if (a == NULL) 
+        return NULL; 
+
+      /* Initialize arena and add its blocks to the free list. */
+      a->magic = ARENA_MAGIC;
+      a->desc = d;
+      a->free_cnt = d->blocks_per_arena;
+      for (i = 0; i < d->blocks_per_arena; i++) 
+        {
+          struct block *b = arena_to_block (a, i);
+          list_push_back (&d->free_list, &b->free_elem);
+        }
+      d->empty_cnt++;
+    }
+
+  /* Get a block from free list. */
+  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
+  a = block_to_arena (b);
+  if (a->free_cnt-- == d->blocks_per_arena)
+    d->empty_cnt--;
+  return b;
+}
+
+/* Adds block B to D's free list.  If B's arena now has no
+   in-use blocks, and D already keeps enough empty arenas, frees
+   the arena.  D's lock must be held. */
+static void
+put_block (struct desc *d, struct block *b) 
+{
+  struct arena *a = block_to_arena (b);
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+  ASSERT (a->desc == d);
+
+  /* Add block to free list. */
+  list_push_front (&d->free_list, &b->free_elem);
+
+  /* If the arena is now entirely unused, keep it or free it. */
+  if (++a->free_cnt >= d->blocks_per_arena) 
+    {
+      size_t i;
+
+      ASSERT (a->free_cnt == d->blocks_per_arena);
+      if (d->empty_cnt < malloc_empty_arenas)
+        {
+          d->empty_cnt++;
+          return;
+        }
+      for (i = 0; i < d->blocks_per_arena; i++) 
+        {
+          struct block *b = arena_to_block (a, i);
+          list_remove (&b->free_elem);
+        }
+      palloc_free_page (a);
+    }
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
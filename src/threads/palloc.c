@@ -2,6 +2,7 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -23,14 +24,54 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is managed as a binary buddy allocator.  Its free
+   pages are grouped into blocks of 2**K pages, for "order" K,
+   each aligned on a 2**K-page boundary from the pool's base, and
+   kept on one free list per order.  An allocation of N pages
+   takes a block from the smallest nonempty list whose order
+   holds N pages, splitting it in half as often as it can, and
+   gives back the unused pages at the end.  Freeing pages merges
+   each freed block with its "buddy", the other half of the
+   block of the next higher order, as long as the buddy is also
+   free.
+
+   A bitmap of used pages is kept alongside, to check frees and
+   to find a run of free pages that straddles block boundaries
+   when no single block is big enough. */
+
+/* Number of block orders.  A block of order K holds 2**K
+   pages. */
+#define ORDER_CNT 20
+
+/* Value of a pool's ORDER[] for a page that does not begin a
+   free block. */
+#define NOT_FREE 0xff
+
+/* A free block, stored at the start of its own first page. */
+struct free_block
+  {
+    struct list_elem elem;              /* Element in a free list. */
+  };
 
 /* A memory pool. */
 struct pool
   {
     struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
+    struct bitmap *used_map;            /* Bitmap of used pages. */
+    uint8_t *order;                     /* Order of the free block
+                                           beginning at each page. */
+    struct list free_lists[ORDER_CNT];  /* Free blocks by order. */
+    unsigned nonempty;                  /* Bit K set if FREE_LISTS[K]
+                                           is not empty. */
     uint8_t *base;                      /* Base of pool. */
+    const char *name;                   /* Name, for statistics. */
+
+    /* Statistics. */
+    size_t free_cnt;                    /* Number of free pages. */
+    unsigned long long scan_cnt;        /* Allocations that had to
+                                           scan USED_MAP. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -38,7 +79,17 @@ static struct pool kernel_pool, user_pool;
 
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
+static struct pool *pool_of (void *pages);
 static bool page_from_pool (const struct pool *, void *page);
+static unsigned order_of (size_t page_cnt);
+static struct free_block *idx_to_block (const struct pool *, size_t page_idx);
+static void push_block (struct pool *, size_t page_idx, unsigned order);
+static void remove_block (struct pool *, size_t page_idx, unsigned order);
+static size_t pop_block (struct pool *, unsigned order);
+static void free_block (struct pool *, size_t page_idx, unsigned order);
+static void free_range (struct pool *, size_t page_idx, size_t page_cnt);
+static void take_range (struct pool *, size_t page_idx, size_t page_cnt);
+static void print_pool_stats (struct pool *);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -73,12 +124,33 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
   void *pages;
   size_t page_idx;
+  unsigned order;
 
   if (page_cnt == 0)
     return NULL;
 
   lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+  order = order_of (page_cnt);
+  page_idx = order < ORDER_CNT ? pop_block (pool, order) : BITMAP_ERROR;
+  if (page_idx != BITMAP_ERROR)
+    {
+      /* Give back the pages we don't need. */
+      free_range (pool, page_idx + page_cnt, ((size_t) 1 << order) - page_cnt);
+    }
+  else if (page_cnt <= pool->free_cnt)
+    {
+      /* No block is big enough, but the pages might still be free
+         in a run that straddles block boundaries. */
+      page_idx = bitmap_scan (pool->used_map, 0, page_cnt, false);
+      if (page_idx != BITMAP_ERROR)
+        take_range (pool, page_idx, page_cnt);
+      pool->scan_cnt++;
+    }
+  if (page_idx != BITMAP_ERROR)
+    {
+      bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+      pool->free_cnt -= page_cnt;
+    }
   lock_release (&pool->lock);
 
   if (page_idx != BITMAP_ERROR)
@@ -113,7 +185,9 @@ palloc_get_page (enum palloc_flags flags)
   return palloc_get_multiple (flags, 1);
 }
 
-/* Frees the PAGE_CNT pages starting at PAGES. */
+/* Frees the PAGE_CNT pages starting at PAGES.  They need not be
+   exactly the pages of one palloc_get_multiple() call, but all
+   of them must be in use. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) 
 {
@@ -124,21 +198,19 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   if (pages == NULL || page_cnt == 0)
     return;
 
-  if (page_from_pool (&kernel_pool, pages))
-    pool = &kernel_pool;
-  else if (page_from_pool (&user_pool, pages))
-    pool = &user_pool;
-  else
-    NOT_REACHED ();
-
+  pool = pool_of (pages);
   page_idx = pg_no (pages) - pg_no (pool->base);
 
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
+  lock_acquire (&pool->lock);
   ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
   bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  free_range (pool, page_idx, page_cnt);
+  pool->free_cnt += page_cnt;
+  lock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
@@ -148,25 +220,90 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Tries to grow the PAGE_CNT-page block at PAGES, obtained from
+   palloc_get_multiple(), in place by the EXTRA_CNT pages that
+   follow it.  Returns true if those pages were free and now
+   belong to the block, false if the block cannot grow. */
+bool
+palloc_extend (void *pages, size_t page_cnt, size_t extra_cnt)
+{
+  struct pool *pool;
+  size_t page_idx;
+  bool success = false;
+
+  ASSERT (pg_ofs (pages) == 0);
+
+  pool = pool_of (pages);
+  page_idx = pg_no (pages) - pg_no (pool->base) + page_cnt;
+  lock_acquire (&pool->lock);
+  if (page_idx + extra_cnt <= bitmap_size (pool->used_map)
+      && bitmap_none (pool->used_map, page_idx, extra_cnt))
+    {
+      take_range (pool, page_idx, extra_cnt);
+      bitmap_set_multiple (pool->used_map, page_idx, extra_cnt, true);
+      pool->free_cnt -= extra_cnt;
+      success = true;
+    }
+  lock_release (&pool->lock);
+  return success;
+}
+
+/* Prints free page and fragmentation statistics for each
+   pool. */
+void
+palloc_print_stats (void) 
+{
+  print_pool_stats (&kernel_pool);
+  print_pool_stats (&user_pool);
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
+  /* We'll put the pool's used_map and then its order array at
+     its base.  Calculate the space needed for them and subtract
+     it from the pool's size. */
+  size_t meta_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt) + page_cnt,
+                                    PGSIZE);
+  size_t bm_size;
+  unsigned order;
+
+  if (meta_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  page_cnt -= meta_pages;
+  bm_size = bitmap_buf_size (page_cnt);
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  lock_init_named (&p->lock, name);
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_size);
+  p->order = (uint8_t *) base + bm_size;
+  memset (p->order, NOT_FREE, page_cnt);
+  for (order = 0; order < ORDER_CNT; order++)
+    list_init (&p->free_lists[order]);
+  p->nonempty = 0;
+  p->base = base + meta_pages * PGSIZE;
+  p->name = name;
+  p->free_cnt = page_cnt;
+  p->scan_cnt = 0;
+
+  /* Put all of its pages on the free lists. */
+  free_range (p, 0, page_cnt);
+}
+
+/* Returns the pool that PAGES were allocated from. */
+static struct pool *
+pool_of (void *pages) 
+{
+  if (page_from_pool (&kernel_pool, pages))
+    return &kernel_pool;
+  else if (page_from_pool (&user_pool, pages))
+    return &user_pool;
+  else
+    NOT_REACHED ();
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -180,3 +317,168 @@ page_from_pool (const struct pool *pool, void *page)
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the smallest order whose blocks hold PAGE_CNT
+   pages. */
+static unsigned
+order_of (size_t page_cnt) 
+{
+  unsigned order = 0;
+
+  while (((size_t) 1 << order) < page_cnt)
+    order++;
+  return order;
+}
+
+/* Returns the address of the PAGE_IDX'th page in POOL. */
+static struct free_block *
+idx_to_block (const struct pool *pool, size_t page_idx) 
+{
+  return (struct free_block *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Puts the free block of the given ORDER at PAGE_IDX on POOL's
+   free list for ORDER. */
+static void
+push_block (struct pool *pool, size_t page_idx, unsigned order) 
+{
+  pool->order[page_idx] = order;
+  list_push_front (&pool->free_lists[order],
+                   &idx_to_block (pool, page_idx)->elem);
+  pool->nonempty |= 1u << order;
+}
+
+/* Removes the free block of the given ORDER at PAGE_IDX from
+   POOL's free list for ORDER. */
+static void
+remove_block (struct pool *pool, size_t page_idx, unsigned order) 
+{
+  ASSERT (pool->order[page_idx] == order);
+
+  pool->order[page_idx] = NOT_FREE;
+  list_remove (&idx_to_block (pool, page_idx)->elem);
+  if (list_empty (&pool->free_lists[order]))
+    pool->nonempty &= ~(1u << order);
+}
+
+/* Takes a free block of ORDER from POOL, splitting a bigger
+   block if there is none of ORDER, and returns the index of its
+   first page.  Returns BITMAP_ERROR if no block is big
+   enough. */
+static size_t
+pop_block (struct pool *pool, unsigned order) 
+{
+  unsigned avail = pool->nonempty & ~((1u << order) - 1);
+  struct free_block *b;
+  size_t page_idx;
+  unsigned k;
+
+  if (avail == 0)
+    return BITMAP_ERROR;
+
+  k = __builtin_ctz (avail);
+  b = list_entry (list_front (&pool->free_lists[k]), struct free_block, elem);
+  page_idx = ((uint8_t *) b - pool->base) / PGSIZE;
+  remove_block (pool, page_idx, k);
+
+  /* Put the upper half back as long as the lower half is big
+     enough. */
+  while (k > order)
+    {
+      k--;
+      push_block (pool, page_idx + ((size_t) 1 << k), k);
+    }
+  return page_idx;
+}
+
+/* Frees the block of ORDER at PAGE_IDX in POOL, merging it with
+   its buddy for as long as the buddy is free. */
+static void
+free_block (struct pool *pool, size_t page_idx, unsigned order) 
+{
+  while (order + 1 < ORDER_CNT)
+    {
+      size_t buddy = page_idx ^ ((size_t) 1 << order);
+      if (buddy >= bitmap_size (pool->used_map)
+          || pool->order[buddy] != order)
+        break;
+      remove_block (pool, buddy, order);
+      if (buddy < page_idx)
+        page_idx = buddy;
+      order++;
+    }
+  push_block (pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX in POOL, as the biggest
+   aligned blocks that fit. */
+static void
+free_range (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  while (page_cnt > 0)
+    {
+      unsigned order = page_idx != 0 ? __builtin_ctz (page_idx) : ORDER_CNT - 1;
+      if (order > ORDER_CNT - 1)
+        order = ORDER_CNT - 1;
+      while (((size_t) 1 << order) > page_cnt)
+        order--;
+
+      free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Removes the PAGE_CNT pages at PAGE_IDX in POOL, which must all
+   be free, from the free lists, and gives back the parts of the
+   blocks they were in that lie outside them. */
+static void
+take_range (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  size_t end = page_idx + page_cnt;
+
+  while (page_idx < end)
+    {
+      size_t start, block_end;
+      unsigned order;
+
+      /* Find the free block that holds PAGE_IDX. */
+      for (order = 0; ; order++)
+        {
+          ASSERT (order < ORDER_CNT);
+          start = page_idx & ~(((size_t) 1 << order) - 1);
+          if (pool->order[start] == order)
+            break;
+        }
+      remove_block (pool, start, order);
+
+      block_end = start + ((size_t) 1 << order);
+      free_range (pool, start, page_idx - start);
+      if (block_end > end)
+        {
+          free_range (pool, end, block_end - end);
+          block_end = end;
+        }
+      page_idx = block_end;
+    }
+}
+
+/* Prints statistics for POOL. */
+static void
+print_pool_stats (struct pool *pool) 
+{
+  size_t largest = 0;
+  unsigned order;
+
+  if (pool->nonempty != 0)
+    largest = (size_t) 1 << (31 - __builtin_clz (pool->nonempty));
+  printf ("%s: %zu of %zu pages free, largest free block %zu pages, "
+          "%llu allocations scanned\n",
+          pool->name, pool->free_cnt, bitmap_size (pool->used_map),
+          largest, pool->scan_cnt);
+  printf ("%s: free blocks by order:", pool->name);
+  for (order = 0; order < ORDER_CNT; order++)
+    if (pool->nonempty & (1u << order))
+      printf (" %u:%zu", order, list_size (&pool->free_lists[order]));
+  printf ("\n");
+}
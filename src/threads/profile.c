@@ -0,0 +1,161 @@
+#include "threads/profile.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/loader.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Number of pages in the histogram.  The number of slots that
+   fit must be a power of 2, so this must be too. */
+#define PROFILE_PAGES 16
+
+/* Number of slots in the histogram. */
+#define PROFILE_SLOT_CNT \
+        (PROFILE_PAGES * PGSIZE / sizeof (struct profile_slot))
+
+/* Maximum number of slots to probe before dropping a sample. */
+#define PROFILE_MAX_PROBES 16
+
+/* A histogram slot: the number of samples taken at a particular
+   instruction, called from a particular site, in a particular
+   thread. */
+struct profile_slot
+  {
+    uint32_t eip;               /* Interrupted instruction, 0 if unused. */
+    uint32_t caller;            /* Return address in caller, 0 if unknown. */
+    uint32_t tid;               /* Interrupted thread. */
+    uint32_t cnt;               /* Number of samples. */
+  };
+
+/* Histogram, as an open-addressed hash table. */
+static struct profile_slot *slots;
+static size_t slots_used;
+
+/* Take a sample every DIVISOR timer ticks.
+   TICKS_LEFT counts down to the next sample. */
+static unsigned divisor = 1;
+static unsigned ticks_left;
+
+/* Statistics. */
+static long long sample_cnt;    /* # of samples recorded. */
+static long long dropped_cnt;   /* # of samples with no free slot. */
+
+/* Is profiling enabled?  Set by profile_init() if requested. */
+bool profile_enabled;
+static bool profile_requested;
+
+static uint32_t frame_caller (const struct intr_frame *);
+
+/* Requests profiling, with a sample taken every DIVISOR timer
+   ticks.  Takes effect in profile_init(). */
+void
+profile_configure (unsigned divisor_)
+{
+  ASSERT (divisor_ > 0);
+
+  profile_requested = true;
+  divisor = divisor_;
+}
+
+/* Allocates the histogram and enables profiling, if profiling
+   was requested.  Must be called after palloc_init(). */
+void
+profile_init (void)
+{
+  if (!profile_requested)
+    return;
+
+  slots = palloc_get_multiple (PAL_ASSERT | PAL_ZERO, PROFILE_PAGES);
+  ticks_left = divisor;
+  profile_enabled = true;
+}
+
+/* Called by the timer interrupt handler with the interrupted
+   thread's frame F.  Every DIVISOR calls, records a sample. */
+void
+profile_sample (const struct intr_frame *f)
+{
+  uint32_t eip, caller, tid, hash;
+  int probe;
+
+  ASSERT (intr_context ());
+
+  if (!profile_enabled || --ticks_left > 0)
+    return;
+  ticks_left = divisor;
+
+  eip = (uint32_t) f->eip;
+  caller = frame_caller (f);
+  tid = thread_tid ();
+  hash = (eip ^ caller * 31 ^ tid * 131) * 2654435761u;
+
+  for (probe = 0; probe < PROFILE_MAX_PROBES; probe++)
+    {
+      struct profile_slot *s = &slots[(hash + probe) % PROFILE_SLOT_CNT];
+      if (s->eip == 0)
+        {
+          s->eip = eip;
+          s->caller = caller;
+          s->tid = tid;
+          slots_used++;
+        }
+      else if (s->eip != eip || s->caller != caller || s->tid != tid)
+        continue;
+
+      s->cnt++;
+      sample_cnt++;
+      return;
+    }
+  dropped_cnt++;
+}
+
+/* Disables profiling and prints the histogram to the console,
+   one line per slot. */
+void
+profile_dump (void)
+{
+  size_t i;
+
+  if (!profile_enabled)
+    return;
+  profile_enabled = false;
+
+  printf ("profile: begin, %lld samples, %zu sites, %lld dropped, "
+          "every %u ticks\n", sample_cnt, slots_used, dropped_cnt, divisor);
+  for (i = 0; i < PROFILE_SLOT_CNT; i++)
+    {
+      const struct profile_slot *s = &slots[i];
+      if (s->eip != 0)
+        printf ("P %08"PRIx32" %08"PRIx32" %"PRIu32" %"PRIu32"\n",
+                s->eip, s->caller, s->tid, s->cnt);
+    }
+  printf ("profile: end\n");
+}
+
+/* Returns the return address into the caller of the function
+   interrupted in F, or 0 if it cannot be found.
+
+   This relies on the interrupted function having set up a frame
+   pointer.  We only believe a frame pointer that lies within the
+   interrupted kernel thread's stack. */
+static uint32_t
+frame_caller (const struct intr_frame *f)
+{
+  struct thread *t = thread_current ();
+  uint8_t *stack_bottom = (uint8_t *) (t + 1);
+  uint8_t *stack_top = (uint8_t *) t + PGSIZE;
+  uint32_t *ebp = (uint32_t *) f->ebp;
+  uint32_t caller;
+
+  if (f->cs != SEL_KCSEG
+      || (uint8_t *) ebp < stack_bottom
+      || (uint8_t *) (ebp + 2) > stack_top)
+    return 0;
+
+  caller = ebp[1];
+  return is_kernel_vaddr ((void *) caller) ? caller : 0;
+}
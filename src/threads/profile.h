@@ -0,0 +1,23 @@
+#ifndef THREADS_PROFILE_H
+#define THREADS_PROFILE_H
+
+#include <stdbool.h>
+
+/* Statistical profiler.
+
+   When enabled with the "-profile" kernel command-line option,
+   every Nth timer interrupt records where the interrupted thread
+   was executing, along with its caller and tid, in a histogram.
+   The histogram is printed at power off for symbolization by
+   utils/pintos-profile. */
+
+struct intr_frame;
+
+extern bool profile_enabled;
+
+void profile_configure (unsigned divisor);
+void profile_init (void);
+void profile_sample (const struct intr_frame *);
+void profile_dump (void);
+
+#endif /* threads/profile.h */
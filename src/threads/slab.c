@@ -0,0 +1,259 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab0bec
+
+/* A slab: one page, with this header at its start, followed by
+   the indexes of its free objects and then the objects
+   themselves.  Keeping the free list out of the objects leaves
+   free objects in their constructed state. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in one of the cache's lists. */
+    size_t free_cnt;            /* Number of free objects. */
+    uint16_t free[];            /* Indexes of free objects. */
+  };
+
+/* All caches, for statistics.
+   Access with interrupts off. */
+static struct list all_caches = LIST_INITIALIZER (all_caches);
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (void *);
+static void *slab_obj (struct slab *, size_t idx);
+
+/* Initializes C as a cache, named NAME, of objects of SIZE bytes
+   aligned on ALIGN-byte boundaries, which must be a power of 2.
+   If CTOR is nonnull, it is called on each object when its slab
+   is created. */
+void
+kmem_cache_init (struct kmem_cache *c, const char *name,
+                 size_t size, size_t align, kmem_ctor_func *ctor)
+{
+  enum intr_level old_level;
+  size_t n;
+
+  ASSERT (c != NULL);
+  ASSERT (size > 0);
+  ASSERT (align > 0 && (align & (align - 1)) == 0);
+
+  /* Fit as many objects in a slab as there is room for, along
+     with the slab header and an index for each object. */
+  size = ROUND_UP (size, align);
+  n = (PGSIZE - sizeof (struct slab)) / (size + sizeof (uint16_t));
+  while (n > 0
+         && (ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t), align)
+             + n * size) > PGSIZE)
+    n--;
+  ASSERT (n > 0);
+
+  c->name = name;
+  c->obj_size = size;
+  c->align = align;
+  c->objs_per_slab = n;
+  c->objs_ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t), align);
+  c->ctor = ctor;
+  lock_init_named (&c->lock, name);
+  list_init (&c->partial);
+  list_init (&c->full);
+  list_init (&c->empty);
+  c->empty_cnt = 0;
+  c->empty_max = KMEM_EMPTY_MAX;
+  c->slab_cnt = c->obj_cnt = c->max_obj_cnt = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&all_caches, &c->allelem);
+  intr_set_level (old_level);
+}
+
+/* Obtains and returns an object from cache C.
+   Returns a null pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c)
+{
+  struct slab *s;
+  void *obj;
+
+  lock_acquire (&c->lock);
+
+  /* Prefer a partial slab, then a cached empty one, and only
+     then a new one. */
+  if (list_empty (&c->partial))
+    {
+      if (!list_empty (&c->empty))
+        {
+          s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+          c->empty_cnt--;
+        }
+      else
+        {
+          s = slab_create (c);
+          if (s == NULL)
+            {
+              lock_release (&c->lock);
+              return NULL;
+            }
+        }
+      list_push_front (&c->partial, &s->elem);
+    }
+  s = list_entry (list_front (&c->partial), struct slab, elem);
+
+  /* Take an object from it. */
+  obj = slab_obj (s, s->free[--s->free_cnt]);
+  if (s->free_cnt == 0)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->full, &s->elem);
+    }
+  if (++c->obj_cnt > c->max_obj_cnt)
+    c->max_obj_cnt = c->obj_cnt;
+
+  lock_release (&c->lock);
+  return obj;
+}
+
+/* Obtains an object from cache C, which must not have a
+   constructor, and clears it to zeros.  Returns a null pointer
+   if memory is not available. */
+void *
+kmem_cache_zalloc (struct kmem_cache *c)
+{
+  void *obj;
+
+  ASSERT (c->ctor == NULL);
+
+  obj = kmem_cache_alloc (c);
+  if (obj != NULL)
+    memset (obj, 0, c->obj_size);
+  return obj;
+}
+
+/* Returns OBJ, which must have been obtained from cache C, to
+   C. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj)
+{
+  struct slab *s;
+  size_t idx;
+
+  if (obj == NULL)
+    return;
+
+  s = obj_to_slab (obj);
+  ASSERT (s->cache == c);
+  idx = ((uint8_t *) obj - (uint8_t *) s - c->objs_ofs) / c->obj_size;
+  ASSERT (slab_obj (s, idx) == obj);
+
+  /* Clear the object to help detect use-after-free bugs, unless
+     it must stay constructed. */
+  if (malloc_poison && c->ctor == NULL)
+    memset (obj, 0xcc, c->obj_size);
+
+  lock_acquire (&c->lock);
+
+  ASSERT (s->free_cnt < c->objs_per_slab);
+  s->free[s->free_cnt++] = idx;
+  c->obj_cnt--;
+
+  if (s->free_cnt == 1 && c->objs_per_slab > 1)
+    {
+      /* It was full; now it is partial. */
+      list_remove (&s->elem);
+      list_push_front (&c->partial, &s->elem);
+    }
+  else if (s->free_cnt == c->objs_per_slab)
+    {
+      /* It is now empty.  Keep it, unless we have enough. */
+      list_remove (&s->elem);
+      if (c->empty_cnt < c->empty_max)
+        {
+          list_push_front (&c->empty, &s->elem);
+          c->empty_cnt++;
+        }
+      else
+        {
+          s->magic = 0;
+          c->slab_cnt--;
+          palloc_free_page (s);
+        }
+    }
+
+  lock_release (&c->lock);
+}
+
+/* Prints statistics for each cache. */
+void
+kmem_cache_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    {
+      struct kmem_cache *c = list_entry (e, struct kmem_cache, allelem);
+
+      printf ("Cache %s: %zu objects of %zu bytes in use (%zu max), "
+              "%zu slabs, %zu bytes overhead\n",
+              c->name, c->obj_cnt, c->obj_size, c->max_obj_cnt,
+              c->slab_cnt, c->slab_cnt * PGSIZE - c->obj_cnt * c->obj_size);
+    }
+}
+
+/* Allocates a new slab for cache C and constructs its objects.
+   Returns the slab, or a null pointer if memory is not
+   available.  C's lock must be held. */
+static struct slab *
+slab_create (struct kmem_cache *c)
+{
+  struct slab *s;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&c->lock));
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->free_cnt = c->objs_per_slab;
+  for (i = 0; i < c->objs_per_slab; i++)
+    {
+      /* Hand out the lowest-addressed objects first. */
+      s->free[i] = c->objs_per_slab - 1 - i;
+      if (c->ctor != NULL)
+        c->ctor (slab_obj (s, i));
+    }
+  c->slab_cnt++;
+  return s;
+}
+
+/* Returns the slab that OBJ is inside. */
+static struct slab *
+obj_to_slab (void *obj)
+{
+  struct slab *s = pg_round_down (obj);
+
+  ASSERT (s != NULL);
+  ASSERT (s->magic == SLAB_MAGIC);
+  return s;
+}
+
+/* Returns the IDX'th object in slab S. */
+static void *
+slab_obj (struct slab *s, size_t idx)
+{
+  ASSERT (idx < s->cache->objs_per_slab);
+  return (uint8_t *) s + s->cache->objs_ofs + idx * s->cache->obj_size;
+}
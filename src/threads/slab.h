@@ -0,0 +1,64 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* Object caches for fixed-size kernel objects.
+
+   malloc() rounds each request up to a power of 2, which wastes
+   up to half of each block and makes every object of a given
+   size class contend for one lock.  A kmem_cache instead holds
+   objects of a single type, packed at their exact size and
+   alignment into pages ("slabs") obtained from the page
+   allocator.
+
+   A cache may have a constructor, which is called on each
+   object once, when its slab is created, rather than on every
+   allocation.  An object must be returned to the cache in its
+   constructed state.
+
+   Each cache keeps its slabs on three lists: full, partially
+   full, and empty.  Objects are allocated from partial slabs
+   first, so that memory is concentrated in as few slabs as
+   possible.  A few empty slabs are kept to avoid returning a
+   page to the page allocator only to ask for it again on the
+   next allocation; beyond that, empty slabs are freed. */
+
+typedef void kmem_ctor_func (void *);
+
+/* An object cache. */
+struct kmem_cache
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t obj_size;            /* Object size, rounded up to ALIGN. */
+    size_t align;               /* Object alignment. */
+    size_t objs_per_slab;       /* Number of objects in a slab. */
+    size_t objs_ofs;            /* Offset of first object in a slab. */
+    kmem_ctor_func *ctor;       /* Constructor, or null. */
+    struct lock lock;           /* Protects the members below. */
+    struct list partial;        /* Slabs with some objects free. */
+    struct list full;           /* Slabs with no objects free. */
+    struct list empty;          /* Slabs with all objects free. */
+    size_t empty_cnt;           /* Number of slabs in EMPTY. */
+    size_t empty_max;           /* Maximum EMPTY_CNT. */
+    struct list_elem allelem;   /* Element in list of all caches. */
+
+    /* Statistics. */
+    size_t slab_cnt;            /* Slabs currently allocated. */
+    size_t obj_cnt;             /* Objects currently in use. */
+    size_t max_obj_cnt;         /* Largest OBJ_CNT seen. */
+  };
+
+/* Default maximum number of empty slabs a cache keeps. */
+#define KMEM_EMPTY_MAX 2
+
+void kmem_cache_init (struct kmem_cache *, const char *name,
+                      size_t size, size_t align, kmem_ctor_func *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void *kmem_cache_zalloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_cache_print_stats (void);
+
+#endif /* threads/slab.h */
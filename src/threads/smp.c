@@ -0,0 +1,112 @@
+#include "threads/smp.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/lapic.h"
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/spinlock.h"
+#include "threads/vaddr.h"
+
+/* Milliseconds to wait for the application processors to start
+   after the last start-up interrupt. */
+#define AP_WAIT_MS 100
+
+/* Startup code for the application processors, in start.S.
+   The code from ap_trampoline to ap_trampoline_end runs in real
+   mode, so it is copied below 1 MB. */
+extern char ap_trampoline[], ap_trampoline_end[];
+
+/* Stacks for the application processors.  start.S gives each
+   processor that starts the stack at byte offset ap_stack_ofs,
+   and advances ap_stack_ofs by AP_STACK_SIZE. */
+uint8_t ap_stacks[CPU_MAX - 1][AP_STACK_SIZE];
+uint32_t ap_stack_ofs;
+
+/* Local APIC IDs of the CPUs that have started, the boot CPU's
+   first. */
+static struct spinlock cpu_lock;
+static unsigned cpu_ids[CPU_MAX];
+static unsigned cpu_cnt;
+
+/* Start the application processors in smp_init()? */
+static bool smp_requested;
+
+void ap_main (void) NO_RETURN;
+
+/* Requests that smp_init() start the application processors. */
+void
+smp_configure (void)
+{
+  smp_requested = true;
+}
+
+/* Starts the application processors, if requested, and reports
+   how many CPUs are running.  Must be called after
+   timer_calibrate(), because starting a processor takes delays
+   of some microseconds and milliseconds.
+
+   We do not read the BIOS's MP or ACPI tables, so we do not know
+   how many application processors there are.  Instead, we start
+   all of them at once and count those that check in. */
+void
+smp_init (void)
+{
+  enum intr_level old_level;
+  unsigned cnt, i;
+
+  if (!smp_requested)
+    return;
+
+  if (!lapic_init ())
+    {
+      printf ("smp: no local APIC, using the boot CPU only.\n");
+      return;
+    }
+  spinlock_init (&cpu_lock);
+  cpu_ids[0] = lapic_id ();
+  cpu_cnt = 1;
+
+  memcpy (ptov (AP_TRAMPOLINE), ap_trampoline,
+          ap_trampoline_end - ap_trampoline);
+
+  /* The INIT, start-up, start-up sequence of [IA32-v3a] 8.4.4.1
+     "Typical BSP Initialization Sequence". */
+  lapic_send_init ();
+  timer_msleep (10);
+  for (i = 0; i < 2; i++)
+    {
+      lapic_send_startup (AP_TRAMPOLINE);
+      timer_usleep (200);
+    }
+  timer_msleep (AP_WAIT_MS);
+
+  old_level = intr_disable ();
+  spinlock_acquire (&cpu_lock);
+  cnt = cpu_cnt;
+  spinlock_release (&cpu_lock);
+  intr_set_level (old_level);
+
+  printf ("smp: %u CPU%s, local APIC IDs", cnt, cnt != 1 ? "s" : "");
+  for (i = 0; i < cnt; i++)
+    printf (" %u", cpu_ids[i]);
+  printf (".\n");
+}
+
+/* Entered from start.S by each application processor, on its
+   own stack, with interrupts off.  Records the processor's local
+   APIC ID and halts it for good.
+
+   The processor has no thread, so nothing here may use
+   thread_current(), which rules out locks and printf(). */
+void
+ap_main (void)
+{
+  spinlock_acquire (&cpu_lock);
+  cpu_ids[cpu_cnt++] = lapic_id ();
+  spinlock_release (&cpu_lock);
+
+  for (;;)
+    asm volatile ("cli; hlt" : : : "memory");
+}
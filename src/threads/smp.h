@@ -0,0 +1,28 @@
+#ifndef THREADS_SMP_H
+#define THREADS_SMP_H
+
+/* Multiprocessor startup.
+
+   When enabled with the "-smp" kernel command-line option, the
+   boot CPU starts the other CPUs, the "application processors",
+   through its local APIC.  Each one switches to protected mode
+   with paging, records its local APIC ID, and halts with
+   interrupts off.  Threads still run only on the boot CPU. */
+
+/* Maximum number of CPUs, including the boot CPU. */
+#define CPU_MAX 8
+
+/* Bytes of stack for each application processor. */
+#define AP_STACK_SIZE 1024
+
+/* Physical address to which the application processors' startup
+   code is copied.  Must be page-aligned and below 1 MB, in
+   memory that the loader no longer needs. */
+#define AP_TRAMPOLINE 0x8000
+
+#ifndef __ASSEMBLER__
+void smp_configure (void);
+void smp_init (void);
+#endif
+
+#endif /* threads/smp.h */
@@ -0,0 +1,54 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <debug.h>
+#include <stdint.h>
+#include "threads/atomic.h"
+#include "threads/interrupt.h"
+
+/* Spinlock.
+
+   Disabling interrupts only keeps other code on the same CPU
+   out, so data that CPUs share needs a spinlock too.  A CPU that
+   finds a spinlock held busy-waits until it is released, so a
+   spinlock may be held only briefly, and never across anything
+   that sleeps.
+
+   Interrupts must be off while a spinlock is held.  Otherwise an
+   interrupt handler on the same CPU could spin forever on a lock
+   that the code it interrupted holds. */
+struct spinlock
+  {
+    volatile uint32_t locked;   /* 1 if held, 0 if free. */
+  };
+
+/* Initializes LOCK as free. */
+static inline void
+spinlock_init (struct spinlock *lock)
+{
+  lock->locked = 0;
+}
+
+/* Acquires LOCK, spinning until it is free.  Interrupts must be
+   off. */
+static inline void
+spinlock_acquire (struct spinlock *lock)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  /* Spin on a plain read, so that waiting CPUs share the cache
+     line until the holder releases it. */
+  while (atomic_xchg (&lock->locked, 1) != 0)
+    while (lock->locked != 0)
+      cpu_relax ();
+}
+
+/* Releases LOCK, which the running CPU must hold. */
+static inline void
+spinlock_release (struct spinlock *lock)
+{
+  ASSERT (lock->locked != 0);
+  atomic_xchg (&lock->locked, 0);
+}
+
+#endif /* threads/spinlock.h */
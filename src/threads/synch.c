@@ -29,8 +29,12 @@
 #include "threads/synch.h"
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
+#include "threads/atomic.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/tsc.h"
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -66,16 +70,55 @@ sema_down (struct semaphore *sema)
   ASSERT (!intr_context ());
 
   old_level = intr_disable ();
+  TRACE (TRACE_SEMA_DOWN, sema);
   while (sema->value == 0) 
     {
-      // insertion for semaphore
-      list_push_back (&sema->waiters, &thread_current ()->elem);
+      /* Keep waiters in order of priority, so that sema_up()
+         can just take the first one. */
+      list_insert_ordered (&sema->waiters, &thread_current ()->elem,
+                           list_thread_priority_less, NULL);
       thread_block ();
     }
   sema->value--;
   intr_set_level (old_level);
 }
 
+/* Down or "P" operation on a semaphore, giving up after TICKS
+   timer ticks.  Returns true if the semaphore is decremented,
+   false if the time ran out first.  If TICKS is 0 or less, does
+   not wait at all.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler.  This function may be called with
+   interrupts disabled, but if it sleeps then the next scheduled
+   thread will probably turn interrupts back on. */
+bool
+sema_down_timeout (struct semaphore *sema, int64_t ticks)
+{
+  enum intr_level old_level;
+  int64_t deadline;
+  bool success;
+
+  ASSERT (sema != NULL);
+  ASSERT (!intr_context ());
+
+  old_level = intr_disable ();
+  TRACE (TRACE_SEMA_DOWN, sema);
+  deadline = timer_ticks () + ticks;
+  while (sema->value == 0 && timer_ticks () < deadline)
+    {
+      list_insert_ordered (&sema->waiters, &thread_current ()->elem,
+                           list_thread_priority_less, NULL);
+      thread_block_timeout (deadline);
+    }
+  success = sema->value > 0;
+  if (success)
+    sema->value--;
+  intr_set_level (old_level);
+
+  return success;
+}
+
 /* Down or "P" operation on a semaphore, but only if the
    semaphore is not already 0.  Returns true if the semaphore is
    decremented, false otherwise.
@@ -102,27 +145,60 @@ sema_try_down (struct semaphore *sema)
   return success;
 }
 
+/* Removes and returns the highest-priority thread in WAITERS, a
+   nonempty list of threads linked through their `elem' members
+   and kept in priority order.  The order can be out of date
+   under the multi-level feedback queue scheduler, which
+   recomputes priorities behind our back, and those of blocked
+   threads only on demand, so then we bring them up to date and
+   search the whole list.  Must be called with interrupts off. */
+static struct thread *
+pop_highest_waiter (struct list *waiters)
+{
+  struct list_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (!list_empty (waiters));
+
+  if (thread_mlfqs)
+    {
+      for (e = list_begin (waiters); e != list_end (waiters);
+           e = list_next (e))
+        thread_mlfqs_refresh (list_entry (e, struct thread, elem));
+      e = list_min (waiters, list_thread_priority_less, NULL);
+    }
+  else
+    e = list_front (waiters);
+  list_remove (e);
+  return list_entry (e, struct thread, elem);
+}
+
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
    and wakes up one thread of those waiting for SEMA, if any.
+   Yields the CPU if the thread woken has a higher priority than
+   the running thread.
 
    This function may be called from an interrupt handler. */
 void
 sema_up (struct semaphore *sema) 
 {
   enum intr_level old_level;
+  bool woke = false;
 
   ASSERT (sema != NULL);
 
   old_level = intr_disable ();
-  if (!list_empty (&sema->waiters)) {
-      // priority may have changed
-      list_sort(&sema->waiters, list_thread_priority_less, NULL);
-      thread_unblock (list_entry (list_pop_front (&sema->waiters),
-                                  struct thread, elem));
-  }
+  TRACE (TRACE_SEMA_UP, sema);
+  if (!list_empty (&sema->waiters)) 
+    {
+      thread_unblock (pop_highest_waiter (&sema->waiters));
+      woke = true;
+    }
   sema->value++;
   intr_set_level (old_level);
-  thread_yield ();
+
+  if (woke)
+    thread_preempt ();
 }
 
 static void sema_test_helper (void *sema_);
@@ -162,6 +238,167 @@ sema_test_helper (void *sema_)
     }
 }
 
+#ifdef LOCKSTAT
+/* Lock statistics.
+
+   Locks initialized with the same name, or unnamed locks
+   initialized at the same place in the code, share a "class"
+   that accumulates statistics for all of them.  Keeping the
+   statistics apart from the locks means that a lock may be
+   discarded, e.g. when it is on the stack, without telling
+   anyone.  The classes are printed at power off. */
+
+/* Maximum number of lock classes.  Locks beyond this are not
+   counted. */
+#define LOCK_CLASS_CNT 64
+
+/* Number of classes printed by lock_print_stats(). */
+#define LOCK_CLASS_PRINT_CNT 10
+
+/* Statistics for a class of locks.  Times are in CPU cycles. */
+struct lock_class
+  {
+    const char *name;           /* Name, or null if unnamed. */
+    void *init_site;            /* If unnamed, where lock_init() was called. */
+    unsigned long long acquire_cnt;     /* Times acquired. */
+    unsigned long long contended_cnt;   /* Times we had to wait. */
+    uint64_t wait_total, wait_max;      /* Time spent waiting. */
+    uint64_t hold_total, hold_max;      /* Time spent holding. */
+  };
+
+static struct lock_class lock_classes[LOCK_CLASS_CNT];
+static size_t lock_class_cnt;
+
+/* Returns the class of locks named NAME or, if NAME is null,
+   the class of unnamed locks initialized at INIT_SITE, creating
+   it if necessary.  Returns a null pointer if there are too many
+   classes. */
+static struct lock_class *
+lock_class_lookup (const char *name, void *init_site)
+{
+  struct lock_class *class = NULL;
+  enum intr_level old_level;
+  size_t i;
+
+  old_level = intr_disable ();
+  for (i = 0; i < lock_class_cnt; i++)
+    {
+      struct lock_class *c = &lock_classes[i];
+      if (name != NULL
+          ? c->name != NULL && !strcmp (c->name, name)
+          : c->name == NULL && c->init_site == init_site)
+        {
+          class = c;
+          break;
+        }
+    }
+  if (class == NULL && lock_class_cnt < LOCK_CLASS_CNT)
+    {
+      class = &lock_classes[lock_class_cnt++];
+      class->name = name;
+      class->init_site = init_site;
+    }
+  intr_set_level (old_level);
+
+  return class;
+}
+
+/* Records that the current thread has acquired LOCK after
+   waiting WAIT cycles.  CONTENDED is true if it had to wait. */
+static void
+lock_stat_acquired (struct lock *lock, bool contended, uint64_t wait)
+{
+  struct lock_class *c = lock->class;
+  enum intr_level old_level;
+
+  lock->acquire_tsc = rdtsc ();
+  if (c == NULL)
+    return;
+
+  old_level = intr_disable ();
+  c->acquire_cnt++;
+  if (contended)
+    {
+      c->contended_cnt++;
+      c->wait_total += wait;
+      if (wait > c->wait_max)
+        c->wait_max = wait;
+    }
+  intr_set_level (old_level);
+}
+
+/* Records that the current thread is releasing LOCK. */
+static void
+lock_stat_released (struct lock *lock)
+{
+  struct lock_class *c = lock->class;
+  uint64_t hold = rdtsc () - lock->acquire_tsc;
+  enum intr_level old_level;
+
+  if (c == NULL)
+    return;
+
+  old_level = intr_disable ();
+  c->hold_total += hold;
+  if (hold > c->hold_max)
+    c->hold_max = hold;
+  intr_set_level (old_level);
+}
+
+/* Initializes LOCK, as with lock_init(), and gives it NAME for
+   the purpose of collecting statistics.  NAME must remain valid
+   for as long as the kernel runs. */
+void
+lock_init_named (struct lock *lock, const char *name)
+{
+  ASSERT (lock != NULL);
+  ASSERT (name != NULL);
+
+  lock->holder = NULL;
+  sema_init (&lock->semaphore, 1);
+  lock->class = lock_class_lookup (name, NULL);
+}
+
+/* Prints statistics for the most contended classes of locks. */
+void
+lock_print_stats (void)
+{
+  bool printed[LOCK_CLASS_CNT];
+  size_t i, j;
+
+  printf ("Locks: %zu classes\n", lock_class_cnt);
+  memset (printed, 0, sizeof printed);
+  for (i = 0; i < LOCK_CLASS_PRINT_CNT && i < lock_class_cnt; i++)
+    {
+      const struct lock_class *c = NULL;
+      size_t best = 0;
+
+      /* Find the most contended class not yet printed. */
+      for (j = 0; j < lock_class_cnt; j++)
+        if (!printed[j]
+            && (c == NULL
+                || lock_classes[j].contended_cnt > c->contended_cnt
+                || (lock_classes[j].contended_cnt == c->contended_cnt
+                    && lock_classes[j].wait_total > c->wait_total)))
+          {
+            c = &lock_classes[j];
+            best = j;
+          }
+      printed[best] = true;
+
+      if (c->name != NULL)
+        printf ("Lock %s:", c->name);
+      else
+        printf ("Lock %p:", c->init_site);
+      printf (" %llu acquired, %llu contended, "
+              "wait %llu/%llu cycles total/max, "
+              "hold %llu/%llu cycles total/max\n",
+              c->acquire_cnt, c->contended_cnt,
+              c->wait_total, c->wait_max, c->hold_total, c->hold_max);
+    }
+}
+#endif /* LOCKSTAT */
+
 /* Initializes LOCK.  A lock can be held by at most a single
    thread at any given time.  Our locks are not "recursive", that
    is, it is an error for the thread currently holding a lock to
@@ -184,12 +421,161 @@ lock_init (struct lock *lock)
 
   lock->holder = NULL;
   sema_init (&lock->semaphore, 1);
+#ifdef LOCKSTAT
+  lock->class = lock_class_lookup (NULL, __builtin_return_address (0));
+#endif
+}
+
+/* Maximum length of a chain of priority donations, to bound the
+   time spent donating with interrupts off. */
+#define DONATION_DEPTH_MAX 8
+
+/* Donates the running thread's priority to the holder of the
+   lock it is waiting for, then to the holder of the lock that
+   one is waiting for, and so on.  Must be called with
+   interrupts off. */
+static void
+donate_priority (void)
+{
+  struct thread *t = thread_current ();
+  int depth;
+
+  for (depth = 0; depth < DONATION_DEPTH_MAX; depth++)
+    {
+      struct thread *holder;
+
+      if (t->wait_on_lock == NULL)
+        break;
+      holder = t->wait_on_lock->holder;
+      if (holder == NULL || holder->priority >= t->priority)
+        break;
+      thread_donate_priority (holder, t->priority);
+      t = holder;
+    }
+}
+
+/* Withdraws the donation that the running thread made to the
+   holder of LOCK, after giving up on waiting for it, and lowers
+   the priority of that holder, then of the holder of the lock
+   that one is waiting for, and so on, as far as the donation had
+   reached.  Must be called with interrupts off. */
+static void
+withdraw_donation (struct lock *lock)
+{
+  struct thread *cur = thread_current ();
+  struct thread *holder = lock->holder;
+  struct list_elem *e;
+  int depth;
+
+  if (thread_mlfqs || holder == NULL)
+    return;
+
+  for (e = list_begin (&holder->donations);
+       e != list_end (&holder->donations); e = list_next (e))
+    if (e == &cur->donation_elem)
+      {
+        list_remove (e);
+        break;
+      }
+
+  for (depth = 0; depth < DONATION_DEPTH_MAX; depth++)
+    {
+      int old_priority = holder->priority;
+
+      thread_recompute_priority (holder);
+      if (holder->priority == old_priority || holder->wait_on_lock == NULL)
+        break;
+      holder = holder->wait_on_lock->holder;
+      if (holder == NULL)
+        break;
+    }
+}
+
+/* Makes the threads waiting for LOCK, which the running thread
+   has just acquired, donate their priority to it.  Must be
+   called with interrupts off. */
+static void
+receive_donations (struct lock *lock)
+{
+  struct list *waiters = &lock->semaphore.waiters;
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  if (thread_mlfqs || list_empty (waiters))
+    return;
+
+  for (e = list_begin (waiters); e != list_end (waiters); e = list_next (e))
+    {
+      struct thread *waiter = list_entry (e, struct thread, elem);
+      if (waiter->wait_on_lock == lock)
+        list_push_back (&cur->donations, &waiter->donation_elem);
+    }
+  thread_refresh_priority ();
+}
+
+/* Acquires LOCK, waiting until it becomes available or until
+   timer tick DEADLINE, whichever comes first.  Waits
+   indefinitely if DEADLINE is INT64_MAX.  Returns true if
+   successful, false if the time ran out first. */
+static bool
+lock_acquire_until (struct lock *lock, int64_t deadline)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  bool success = true;
+#ifdef LOCKSTAT
+  uint64_t start = rdtsc ();
+  bool contended = false;
+#endif
+
+  ASSERT (lock != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (!lock_held_by_current_thread (lock));
+
+  old_level = intr_disable ();
+  if (!sema_try_down (&lock->semaphore))
+    {
+#ifdef LOCKSTAT
+      contended = true;
+#endif
+      if (!thread_mlfqs && lock->holder != NULL)
+        {
+          cur->wait_on_lock = lock;
+          list_push_back (&lock->holder->donations, &cur->donation_elem);
+          donate_priority ();
+        }
+      if (deadline == INT64_MAX)
+        sema_down (&lock->semaphore);
+      else
+        success = sema_down_timeout (&lock->semaphore,
+                                     deadline - timer_ticks ());
+      if (!success)
+        withdraw_donation (lock);
+      cur->wait_on_lock = NULL;
+    }
+  if (success)
+    {
+      lock->holder = cur;
+      receive_donations (lock);
+    }
+  intr_set_level (old_level);
+
+#ifdef LOCKSTAT
+  if (success)
+    lock_stat_acquired (lock, contended, contended ? rdtsc () - start : 0);
+#endif
+  return success;
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
 
+   While waiting, the current thread donates its priority to the
+   lock's holder, unless the multi-level feedback queue scheduler
+   is in use.  Once it has the lock, it receives donations from
+   the other threads still waiting for it.
+
    This function may sleep, so it must not be called within an
    interrupt handler.  This function may be called with
    interrupts disabled, but interrupts will be turned back on if
@@ -197,12 +583,17 @@ lock_init (struct lock *lock)
 void
 lock_acquire (struct lock *lock)
 {
-  ASSERT (lock != NULL);
-  ASSERT (!intr_context ());
-  ASSERT (!lock_held_by_current_thread (lock));
+  lock_acquire_until (lock, INT64_MAX);
+}
 
-  sema_down (&lock->semaphore);
-  lock->holder = thread_current ();
+/* Acquires LOCK, as with lock_acquire(), but gives up after
+   TICKS timer ticks.  Returns true if successful, false if the
+   time ran out first.  If TICKS is 0 or less, does not wait at
+   all. */
+bool
+lock_acquire_timeout (struct lock *lock, int64_t ticks)
+{
+  return lock_acquire_until (lock, timer_ticks () + ticks);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -214,14 +605,25 @@ lock_acquire (struct lock *lock)
 bool
 lock_try_acquire (struct lock *lock)
 {
+  enum intr_level old_level;
   bool success;
 
   ASSERT (lock != NULL);
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+      lock->holder = thread_current ();
+      receive_donations (lock);
+    }
+  intr_set_level (old_level);
+
+#ifdef LOCKSTAT
+  if (success)
+    lock_stat_acquired (lock, false, 0);
+#endif
   return success;
 }
 
@@ -233,11 +635,42 @@ lock_try_acquire (struct lock *lock)
 void
 lock_release (struct lock *lock) 
 {
+  enum intr_level old_level;
+
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
+#ifdef LOCKSTAT
+  lock_stat_released (lock);
+#endif
+
+  /* Withdraw the donations made by threads waiting for LOCK.
+     They will donate to its next holder instead. */
+  old_level = intr_disable ();
+  if (!thread_mlfqs)
+    {
+      struct thread *cur = thread_current ();
+      struct list_elem *e;
+
+      for (e = list_begin (&cur->donations); e != list_end (&cur->donations); )
+        {
+          struct thread *donor = list_entry (e, struct thread, donation_elem);
+          if (donor->wait_on_lock == lock)
+            e = list_remove (e);
+          else
+            e = list_next (e);
+        }
+      thread_refresh_priority ();
+    }
+
+  /* Hand LOCK to the highest-priority waiter before turning
+     interrupts back on.  Otherwise a thread could take LOCK in
+     between, ahead of that waiter, or we could be preempted
+     having dropped our donations while the waiter is still
+     blocked. */
   lock->holder = NULL;
   sema_up (&lock->semaphore);
+  intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -251,13 +684,158 @@ lock_held_by_current_thread (const struct lock *lock)
   return lock->holder == thread_current ();
 }
 
+/* Mutex states. */
+#define MUTEX_UNLOCKED 0        /* Not held. */
+#define MUTEX_LOCKED 1          /* Held, no thread waiting. */
+#define MUTEX_CONTENDED 2       /* Held, threads may be waiting. */
+
+/* Maximum number of times to check whether a mutex's holder is
+   still running before blocking. */
+#define MUTEX_SPIN_MAX 100
+
+/* Initializes MUTEX as unlocked. */
+void
+mutex_init (struct mutex *mutex)
+{
+  ASSERT (mutex != NULL);
+
+  mutex->state = MUTEX_UNLOCKED;
+  mutex->holder = NULL;
+  list_init (&mutex->waiters);
+}
+
+/* Waits for MUTEX to become available and acquires it.  Called
+   by mutex_lock() when the fast path fails. */
+static void
+mutex_lock_slow (struct mutex *mutex)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  int spins;
+
+  /* While the holder is running, on another CPU, it is likely
+     to release MUTEX soon, so spinning is cheaper than blocking.
+     On a single CPU the holder cannot be running, so we give up
+     at once. */
+  for (spins = 0; spins < MUTEX_SPIN_MAX; spins++)
+    {
+      struct thread *holder = mutex->holder;
+      if (holder == NULL || holder->status != THREAD_RUNNING)
+        break;
+      cpu_relax ();
+      if (mutex->state == MUTEX_UNLOCKED
+          && atomic_cmpxchg (&mutex->state, MUTEX_UNLOCKED,
+                             MUTEX_LOCKED) == MUTEX_UNLOCKED)
+        return;
+    }
+
+  /* Mark MUTEX contended, so that mutex_unlock() knows to wake
+     us, unless it turns out to be unlocked, in which case it is
+     ours.  With interrupts off, the holder cannot release it
+     between our check and our blocking. */
+  old_level = intr_disable ();
+  while (atomic_xchg (&mutex->state, MUTEX_CONTENDED) != MUTEX_UNLOCKED)
+    {
+      list_insert_ordered (&mutex->waiters, &cur->elem,
+                           list_thread_priority_less, NULL);
+      thread_block ();
+    }
+  intr_set_level (old_level);
+}
+
+/* Acquires MUTEX, waiting until it becomes available if
+   necessary.  The mutex must not already be held by the current
+   thread.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+mutex_lock (struct mutex *mutex)
+{
+  ASSERT (mutex != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (!mutex_held_by_current_thread (mutex));
+
+  if (atomic_cmpxchg (&mutex->state, MUTEX_UNLOCKED, MUTEX_LOCKED)
+      != MUTEX_UNLOCKED)
+    mutex_lock_slow (mutex);
+  mutex->holder = thread_current ();
+}
+
+/* Tries to acquire MUTEX and returns true if successful or false
+   on failure.  The mutex must not already be held by the current
+   thread. */
+bool
+mutex_trylock (struct mutex *mutex)
+{
+  ASSERT (mutex != NULL);
+  ASSERT (!mutex_held_by_current_thread (mutex));
+
+  if (atomic_cmpxchg (&mutex->state, MUTEX_UNLOCKED, MUTEX_LOCKED)
+      != MUTEX_UNLOCKED)
+    return false;
+  mutex->holder = thread_current ();
+  return true;
+}
+
+/* Releases MUTEX, which must be held by the current thread, and
+   wakes the highest-priority waiter, if any. */
+void
+mutex_unlock (struct mutex *mutex)
+{
+  struct thread *woken = NULL;
+  enum intr_level old_level;
+
+  ASSERT (mutex != NULL);
+  ASSERT (mutex_held_by_current_thread (mutex));
+
+  mutex->holder = NULL;
+  if (atomic_xchg (&mutex->state, MUTEX_UNLOCKED) != MUTEX_CONTENDED)
+    return;
+
+  old_level = intr_disable ();
+  if (!list_empty (&mutex->waiters))
+    {
+      woken = pop_highest_waiter (&mutex->waiters);
+      thread_unblock (woken);
+    }
+  intr_set_level (old_level);
+
+  if (woken != NULL)
+    thread_preempt ();
+}
+
+/* Returns true if the current thread holds MUTEX, false
+   otherwise. */
+bool
+mutex_held_by_current_thread (const struct mutex *mutex)
+{
+  ASSERT (mutex != NULL);
+
+  return mutex->holder == thread_current ();
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem 
   {
     struct list_elem elem;              /* List element. */
     struct semaphore semaphore;         /* This semaphore. */
+    struct thread *thread;              /* Thread waiting on it. */
   };
 
+/* Returns true if the thread waiting on semaphore_elem A has a
+   lower priority than the one waiting on B. */
+static bool
+cond_waiter_less (const struct list_elem *a, const struct list_elem *b,
+                  void *aux UNUSED)
+{
+  const struct semaphore_elem *sa
+    = list_entry (a, struct semaphore_elem, elem);
+  const struct semaphore_elem *sb
+    = list_entry (b, struct semaphore_elem, elem);
+  return sa->thread->priority < sb->thread->priority;
+}
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -300,6 +878,7 @@ cond_wait (struct condition *cond, struct lock *lock)
   ASSERT (lock_held_by_current_thread (lock));
   
   sema_init (&waiter.semaphore, 0);
+  waiter.thread = thread_current ();
   list_push_back (&cond->waiters, &waiter.elem);
   lock_release (lock);
   sema_down (&waiter.semaphore);
@@ -307,7 +886,8 @@ cond_wait (struct condition *cond, struct lock *lock)
 }
 
 /* If any threads are waiting on COND (protected by LOCK), then
-   this function signals one of them to wake up from its wait.
+   this function signals the one with the highest priority to
+   wake up from its wait.
    LOCK must be held before calling this function.
 
    An interrupt handler cannot acquire a lock, so it does not
@@ -322,8 +902,25 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED)
   ASSERT (lock_held_by_current_thread (lock));
 
   if (!list_empty (&cond->waiters)) 
-    sema_up (&list_entry (list_pop_front (&cond->waiters),
-                          struct semaphore_elem, elem)->semaphore);
+    {
+      enum intr_level old_level;
+      struct list_elem *e;
+
+      /* Priorities may change while threads wait, so find the
+         highest one now.  The multi-level feedback queue
+         scheduler updates those of blocked threads only on
+         demand. */
+      old_level = intr_disable ();
+      if (thread_mlfqs)
+        for (e = list_begin (&cond->waiters); e != list_end (&cond->waiters);
+             e = list_next (e))
+          thread_mlfqs_refresh (list_entry (e, struct semaphore_elem,
+                                            elem)->thread);
+      e = list_max (&cond->waiters, cond_waiter_less, NULL);
+      list_remove (e);
+      intr_set_level (old_level);
+      sema_up (&list_entry (e, struct semaphore_elem, elem)->semaphore);
+    }
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -341,3 +938,107 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes RWLOCK.  A readers-writer lock may be held by any
+   number of readers at once or by a single writer, but not by
+   readers and a writer at the same time.
+
+   Writers take precedence: once a writer is waiting, new readers
+   wait too, so that a steady stream of readers cannot starve
+   writers.  Among waiting readers, or among waiting writers,
+   threads are admitted in priority order, as for condition
+   variables.  Priority is not donated to readers or writers
+   holding RWLOCK, only to the holder of the internal lock
+   that briefly protects its state. */
+void
+rwlock_init (struct rwlock *rwlock)
+{
+  ASSERT (rwlock != NULL);
+
+  lock_init_named (&rwlock->lock, "rwlock");
+  cond_init (&rwlock->can_read);
+  cond_init (&rwlock->can_write);
+  rwlock->readers = 0;
+  rwlock->writers_waiting = 0;
+  rwlock->writer = NULL;
+}
+
+/* Acquires RWLOCK for reading, sleeping until no writer holds or
+   is waiting for it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rwlock)
+{
+  ASSERT (rwlock != NULL);
+  ASSERT (!rwlock_held_for_write (rwlock));
+
+  lock_acquire (&rwlock->lock);
+  while (rwlock->writer != NULL || rwlock->writers_waiting > 0)
+    cond_wait (&rwlock->can_read, &rwlock->lock);
+  rwlock->readers++;
+  lock_release (&rwlock->lock);
+}
+
+/* Releases RWLOCK, which the current thread must hold for
+   reading. */
+void
+rwlock_release_read (struct rwlock *rwlock)
+{
+  ASSERT (rwlock != NULL);
+
+  lock_acquire (&rwlock->lock);
+  ASSERT (rwlock->readers > 0);
+  if (--rwlock->readers == 0)
+    cond_signal (&rwlock->can_write, &rwlock->lock);
+  lock_release (&rwlock->lock);
+}
+
+/* Acquires RWLOCK for writing, sleeping until no reader or
+   writer holds it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rwlock)
+{
+  ASSERT (rwlock != NULL);
+  ASSERT (!rwlock_held_for_write (rwlock));
+
+  lock_acquire (&rwlock->lock);
+  rwlock->writers_waiting++;
+  while (rwlock->writer != NULL || rwlock->readers > 0)
+    cond_wait (&rwlock->can_write, &rwlock->lock);
+  rwlock->writers_waiting--;
+  rwlock->writer = thread_current ();
+  lock_release (&rwlock->lock);
+}
+
+/* Releases RWLOCK, which the current thread must hold for
+   writing.  Hands it to the next waiting writer, if any, and
+   otherwise to all the waiting readers. */
+void
+rwlock_release_write (struct rwlock *rwlock)
+{
+  ASSERT (rwlock != NULL);
+  ASSERT (rwlock_held_for_write (rwlock));
+
+  lock_acquire (&rwlock->lock);
+  rwlock->writer = NULL;
+  if (rwlock->writers_waiting > 0)
+    cond_signal (&rwlock->can_write, &rwlock->lock);
+  else
+    cond_broadcast (&rwlock->can_read, &rwlock->lock);
+  lock_release (&rwlock->lock);
+}
+
+/* Returns true if the current thread holds RWLOCK for writing,
+   false otherwise. */
+bool
+rwlock_held_for_write (const struct rwlock *rwlock)
+{
+  ASSERT (rwlock != NULL);
+
+  return rwlock->writer == thread_current ();
+}
@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore 
@@ -13,6 +14,7 @@ struct semaphore
 
 void sema_init (struct semaphore *, unsigned value);
 void sema_down (struct semaphore *);
+bool sema_down_timeout (struct semaphore *, int64_t ticks);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
@@ -22,14 +24,46 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+#ifdef LOCKSTAT
+    struct lock_class *class;   /* Statistics for this kind of lock. */
+    uint64_t acquire_tsc;       /* When the holder acquired the lock. */
+#endif
   };
 
 void lock_init (struct lock *);
+#ifdef LOCKSTAT
+void lock_init_named (struct lock *, const char *name);
+void lock_print_stats (void);
+#else
+#define lock_init_named(LOCK, NAME) lock_init (LOCK)
+#endif
 void lock_acquire (struct lock *);
+bool lock_acquire_timeout (struct lock *, int64_t ticks);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Mutex: a lock with a fast path for the uncontended case.
+
+   Acquiring or releasing an uncontended mutex is a single atomic
+   instruction.  On contention, a thread spins briefly if the
+   holder is running on another CPU, and otherwise blocks.
+   Unlike struct lock, a mutex does not donate priority, so it
+   suits short critical sections, such as updates to a
+   bitmap, rather than ones that may sleep. */
+struct mutex
+  {
+    volatile uint32_t state;    /* MUTEX_UNLOCKED, _LOCKED, or _CONTENDED. */
+    struct thread *holder;      /* Thread holding mutex. */
+    struct list waiters;        /* Threads waiting, in priority order. */
+  };
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+bool mutex_held_by_current_thread (const struct mutex *);
+
 /* Condition variable. */
 struct condition 
   {
@@ -41,6 +75,29 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Readers-writer lock.
+
+   Any number of readers may hold it at once, or one writer.
+   Unlike a lock, it does not donate priority: a thread waiting
+   for it does not raise the priority of the readers or the
+   writer holding it. */
+struct rwlock
+  {
+    struct lock lock;           /* Protects the members below. */
+    struct condition can_read;  /* Signaled when readers may enter. */
+    struct condition can_write; /* Signaled when a writer may enter. */
+    unsigned readers;           /* Number of readers holding the lock. */
+    unsigned writers_waiting;   /* Number of writers waiting. */
+    struct thread *writer;      /* Writer holding the lock, if any. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_for_write (const struct rwlock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
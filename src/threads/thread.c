@@ -4,17 +4,18 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/atomic.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
-#include "threads/malloc.h"
 #include "devices/timer.h"
 
 /* Random value for struct thread's `magic' member.
@@ -25,6 +26,7 @@
 /* List of processes in THREAD_READY state, that is, processes
    that are ready to run but not actually running. */
 static struct list ready_list;
+static unsigned ready_cnt;      /* Number of threads in ready_list. */
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
@@ -39,8 +41,13 @@ static struct thread *idle_thread;
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
-/* Lock used by allocate_tid(). */
-static struct lock tid_lock;
+/* Pages of threads that have exited, kept for reuse by
+   thread_create() to save a trip through the page allocator.
+   Each free page starts with a pointer to the next one.  Only
+   accessed with interrupts off. */
+#define THREAD_CACHE_MAX 8
+static void *thread_cache;
+static size_t thread_cache_cnt;
 
 /* Stack frame for kernel_thread(). */
 struct kernel_thread_frame 
@@ -68,6 +75,25 @@ bool thread_prior_aging;
 // ticks for thread_aging
 static uint64_t aging_ticks; 
 
+/* MLFQS load average (17.14 fixed point format), updated once a
+   second, and the number of updates so far. */
+static uint32_t load_avg;
+static int64_t load_avg_seconds;
+
+/* Each second, recent_cpu decays for the running and ready
+   threads only.  A blocked thread catches up on the decays it
+   missed when it becomes ready, using the load average of each
+   of those seconds, kept here indexed by second modulo
+   LOAD_AVG_HISTORY.  For the seconds before those, whose load
+   averages are gone, it approximates the load average by the
+   oldest one kept and applies their decays all at once. */
+#define LOAD_AVG_HISTORY 64
+static uint32_t load_avg_history[LOAD_AVG_HISTORY];
+
+static void decay_recent_cpu (struct thread *, uint32_t load);
+static void decay_recent_cpu_span (struct thread *, uint32_t load,
+                                   int64_t seconds);
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -79,6 +105,8 @@ static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static struct thread *thread_page_get (void);
+static void thread_page_free (struct thread *);
 
 
 /* Initializes the threading system by transforming the code
@@ -86,7 +114,8 @@ static tid_t allocate_tid (void);
    general and it is possible in this case only because loader.S
    was careful to put the bottom of the stack at a page boundary.
 
-   Also initializes the run queue and the tid lock.
+   Also initializes the run queue and the lists of all and
+   sleeping threads.
 
    After calling this function, be sure to initialize the page
    allocator before trying to create any threads with
@@ -99,7 +128,6 @@ thread_init (void)
 {
   ASSERT (intr_get_level () == INTR_OFF);
 
-  lock_init (&tid_lock);
   list_init (&ready_list);
   list_init (&all_list);
   list_init (&blocked_list);
@@ -154,6 +182,16 @@ thread_tick (void)
     struct list_elem *next = list_next(e);
     struct threadwrapper *tw = list_entry(e, struct threadwrapper, threadelem);
     if(tw->wakeup_time <= timer_ticks() ) {
+        // a timed wait that already ended removes its own entry
+        if(tw->t->timeout == tw) {
+            if(tw->t->status != THREAD_BLOCKED) {
+                e = next;
+                continue;
+            }
+            // take it off the queue it was waiting on
+            tw->timed_out = true;
+            list_remove(&tw->t->elem);
+        }
         list_remove(&tw->threadelem);
         thread_unblock(tw->t);
     }
@@ -216,7 +254,7 @@ thread_create (const char *name, int priority,
   ASSERT (function != NULL);
 
   /* Allocate thread. */
-  t = palloc_get_page (PAL_ZERO);
+  t = thread_page_get ();
   if (t == NULL)
     return TID_ERROR;
 
@@ -255,15 +293,13 @@ thread_create (const char *name, int priority,
   // Project 1. nice and recent_cpu value
   t->nice = parent->nice;
   t->recent_cpu = parent->recent_cpu;
+  t->recent_cpu_seconds = parent->recent_cpu_seconds;
 
   /* Add to run queue. */
   thread_unblock (t);
 
-  // update priorities
-  if(thread_mlfqs) {
-    thread_priority_sort ();
+  if(thread_mlfqs)
     t = list_entry(list_begin(&ready_list), struct thread, elem);
-  }
 
   // if new thread has more priority, yield.
   if(t->priority > thread_current()->priority)
@@ -282,23 +318,57 @@ void
 thread_block (void) 
 {
   ASSERT (!intr_context ());
+  ASSERT (!softirq_context ());
   ASSERT (intr_get_level () == INTR_OFF);
 
+  TRACE (TRACE_BLOCK, 0);
   thread_current ()->status = THREAD_BLOCKED;
   schedule ();
 }
 
+/* Blocks the running thread until timer tick WAKEUP_TIME.  The
+   wrapper that puts it on blocked_list lives on its stack, since
+   nothing else refers to it once thread_tick() wakes the thread.
+   Must be called with interrupts off. */
 void
-thread_sleep (int64_t ticks)
+thread_sleep (int64_t wakeup_time)
+{
+  struct threadwrapper tw;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  tw.t = thread_current ();
+  tw.wakeup_time = wakeup_time;
+  tw.timed_out = false;
+  list_push_back (&blocked_list, &tw.threadelem);
+  thread_block ();
+}
+
+/* Blocks the running thread, which the caller has put on a wait
+   queue through its `elem', until it is unblocked or until timer
+   tick WAKEUP_TIME, whichever comes first.  In the latter case,
+   the thread is removed from the wait queue and true is
+   returned.  Must be called with interrupts off. */
+bool
+thread_block_timeout (int64_t wakeup_time)
 {
-  // wrap thread for listing
-  struct threadwrapper *tw = malloc (sizeof(struct threadwrapper));
-  tw->t = thread_current();
-  tw->wakeup_time = ticks;
-  // block thread and push back into blocked_list
-  list_push_back(&blocked_list, &tw->threadelem);
-  // erase from ready list
-  list_remove(&tw->t->elem);
+  struct thread *cur = thread_current ();
+  struct threadwrapper tw;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  tw.t = cur;
+  tw.wakeup_time = wakeup_time;
+  tw.timed_out = false;
+  list_push_back (&blocked_list, &tw.threadelem);
+  cur->timeout = &tw;
+
+  thread_block ();
+
+  cur->timeout = NULL;
+  if (!tw.timed_out)
+    list_remove (&tw.threadelem);
+  return tw.timed_out;
 }
 
 void
@@ -314,8 +384,10 @@ thread_aging (void)
           if(aging_ticks >= AGING_MAX_TICKS) {
               aging_ticks = 0;
               // ready_list is sorted, so after every e, increase priority
-              for(; e!=list_end(&ready_list); e=list_next(e))
-                list_entry(e, struct thread, elem)->priority++;
+              for(; e!=list_end(&ready_list); e=list_next(e)) {
+                  list_entry(e, struct thread, elem)->priority++;
+                  list_entry(e, struct thread, elem)->base_priority++;
+              }
               thread_priority_sort ();
           }
           break;
@@ -340,7 +412,11 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
+  TRACE (TRACE_UNBLOCK, t->tid);
+  if (thread_mlfqs)
+    thread_mlfqs_refresh (t);
   list_insert_ordered(&ready_list, &t->elem, list_thread_priority_less, NULL);
+  ready_cnt++;
   t->status = THREAD_READY;
   intr_set_level (old_level);
 }
@@ -406,15 +482,43 @@ thread_yield (void)
   enum intr_level old_level;
   
   ASSERT (!intr_context ());
+  ASSERT (!softirq_context ());
 
   old_level = intr_disable ();
   if (cur != idle_thread) 
-    list_insert_ordered(&ready_list, &cur->elem, list_thread_priority_less, NULL);
+    {
+      list_insert_ordered(&ready_list, &cur->elem, list_thread_priority_less, NULL);
+      ready_cnt++;
+    }
   cur->status = THREAD_READY;
   schedule ();
   intr_set_level (old_level);
 }
 
+/* Yields the CPU if a ready thread has a higher priority than
+   the running thread.  In an interrupt handler or softirq, the
+   yield is deferred until the interrupt returns. */
+void
+thread_preempt (void)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  bool preempt;
+
+  old_level = intr_disable ();
+  preempt = (!list_empty (&ready_list)
+             && list_entry (list_front (&ready_list),
+                            struct thread, elem)->priority > cur->priority);
+  intr_set_level (old_level);
+
+  if (!preempt)
+    return;
+  if (intr_context () || softirq_context ())
+    intr_yield_on_return ();
+  else
+    thread_yield ();
+}
+
 /* Invoke function 'func' on all threads, passing along 'aux'.
    This function must be called with interrupts off. */
 void
@@ -432,13 +536,23 @@ thread_foreach (thread_action_func *func, void *aux)
     }
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Sets the current thread's priority to NEW_PRIORITY.  If other
+   threads have donated a higher priority, the new priority takes
+   effect only once the donations are withdrawn. */
 void
 thread_set_priority (int new_priority) 
 {
   struct thread *t = thread_current ();
+  enum intr_level old_level = intr_disable ();
   if(t!=idle_thread)
-    t->priority = new_priority;
+    {
+      t->base_priority = new_priority;
+      if(thread_mlfqs)
+        t->priority = new_priority;
+      else
+        thread_refresh_priority ();
+    }
+  intr_set_level (old_level);
   
   // update priorities
   thread_priority_sort ();
@@ -449,6 +563,78 @@ thread_set_priority (int new_priority)
     thread_yield();
 }
 
+/* Moves T, whose priority has just changed, to its place in the
+   ready list, or in the list of waiters for the lock that T is
+   waiting for.  Must be called with interrupts off. */
+static void
+requeue_thread (struct thread *t)
+{
+  if (t->status == THREAD_READY)
+    {
+      list_remove (&t->elem);
+      list_insert_ordered (&ready_list, &t->elem,
+                           list_thread_priority_less, NULL);
+    }
+  else if (t->status == THREAD_BLOCKED && t->wait_on_lock != NULL)
+    {
+      struct list *waiters = &t->wait_on_lock->semaphore.waiters;
+      list_remove (&t->elem);
+      list_insert_ordered (waiters, &t->elem, list_thread_priority_less, NULL);
+    }
+}
+
+/* Raises T's priority to PRIORITY on behalf of a thread waiting
+   for a lock that T holds, keeping the ready list, or the list of
+   waiters for the lock that T is itself waiting for, in order.
+   Has no effect if T's priority is already at least PRIORITY.
+   Must be called with interrupts off. */
+void
+thread_donate_priority (struct thread *t, int priority)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (is_thread (t));
+
+  if (t->priority >= priority)
+    return;
+  t->priority = priority;
+  requeue_thread (t);
+}
+
+/* Recomputes T's priority as the higher of its base priority and
+   the priority of each thread waiting for one of its locks,
+   keeping the ready list, or the list of waiters for the lock
+   that T is itself waiting for, in order.  Must be called with
+   interrupts off. */
+void
+thread_recompute_priority (struct thread *t)
+{
+  int old_priority = t->priority;
+  struct list_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (is_thread (t));
+
+  t->priority = t->base_priority;
+  for (e = list_begin (&t->donations); e != list_end (&t->donations);
+       e = list_next (e))
+    {
+      struct thread *donor = list_entry (e, struct thread, donation_elem);
+      if (donor->priority > t->priority)
+        t->priority = donor->priority;
+    }
+  if (t->priority != old_priority)
+    requeue_thread (t);
+}
+
+/* Recomputes the running thread's priority as the higher of its
+   base priority and the priority of each thread waiting for one
+   of its locks.  Must be called with interrupts off. */
+void
+thread_refresh_priority (void)
+{
+  thread_recompute_priority (thread_current ());
+}
+
 /* Returns the current thread's priority. */
 int
 thread_get_priority (void) 
@@ -466,9 +652,6 @@ thread_set_nice (int nice)
   struct thread *t = thread_current ();
   t->nice = nice;
   thread_update_priority(t, NULL);
- 
-  // update priorities
-  thread_priority_sort ();
   
   struct thread *top = list_entry(list_begin(&ready_list), struct thread, elem);
   
@@ -503,16 +686,48 @@ thread_get_recent_cpu (void)
 void
 thread_update_recent_cpu (struct thread *t, void *aux UNUSED)
 {
-  // recent_cpu and load_avg are 17.14 fixed point format number
+  decay_recent_cpu (t, load_avg);
+}
+
+/* Applies one second of decay to T's recent_cpu, given that
+   second's load average LOAD. */
+static void
+decay_recent_cpu (struct thread *t, uint32_t load)
+{
+  // recent_cpu and load are 17.14 fixed point format number
   uint32_t recent_cpu = t->recent_cpu;
-  uint32_t load_avg = thread_update_load_avg(false);
   uint32_t nice = t->nice * FIXED_INT;
-  recent_cpu = ((uint64_t) (2*load_avg)) * recent_cpu / FIXED_INT;
-  recent_cpu = ((uint64_t) recent_cpu) * FIXED_INT / (2*load_avg + FIXED_INT);
+  recent_cpu = ((uint64_t) (2*load)) * recent_cpu / FIXED_INT;
+  recent_cpu = ((uint64_t) recent_cpu) * FIXED_INT / (2*load + FIXED_INT);
   recent_cpu += nice;
   t->recent_cpu = recent_cpu;
 }
 
+/* Applies SECONDS seconds of decay to T's recent_cpu, given that
+   the load average was LOAD throughout, in O(log SECONDS) time.
+   One second maps recent_cpu to C * recent_cpu + nice, where
+   C = 2 * LOAD / (2 * LOAD + 1), so SECONDS of them map it to
+   C**SECONDS * recent_cpu + nice * (1 - C**SECONDS) / (1 - C),
+   and 1 / (1 - C) = 2 * LOAD + 1. */
+static void
+decay_recent_cpu_span (struct thread *t, uint32_t load, int64_t seconds)
+{
+  // C and C**SECONDS are 17.14 fixed point format numbers
+  uint64_t c = (uint64_t) (2 * load) * FIXED_INT / (2 * load + FIXED_INT);
+  uint64_t c_pow = FIXED_INT;
+  int64_t nice_sum;
+
+  for (; seconds > 0; seconds /= 2)
+    {
+      if (seconds % 2)
+        c_pow = c_pow * c / FIXED_INT;
+      c = c * c / FIXED_INT;
+    }
+  nice_sum = ((int64_t) (int32_t) t->nice * (int64_t) (FIXED_INT - c_pow)
+              * (2 * load + FIXED_INT) / FIXED_INT);
+  t->recent_cpu = c_pow * t->recent_cpu / FIXED_INT + nice_sum;
+}
+
 // Project 1. update priority of thread t.
 void
 thread_update_priority (struct thread *t, void *aux UNUSED)
@@ -530,14 +745,13 @@ thread_update_priority (struct thread *t, void *aux UNUSED)
 int
 thread_update_load_avg (bool update)
 {
-  // load_avg is 17.14 fixed point format number
-  static uint32_t load_avg;
-
   // update load_avg
   if(update) {
-      uint32_t ready_threads = list_size(&ready_list) * FIXED_INT;
+      uint32_t ready_threads = ready_cnt * FIXED_INT;
       if(thread_current() != idle_thread) ready_threads += FIXED_INT;
       load_avg = (load_avg * 59 + ready_threads) / 60;
+      load_avg_seconds++;
+      load_avg_history[load_avg_seconds % LOAD_AVG_HISTORY] = load_avg;
   }
   return load_avg;
 }
@@ -550,6 +764,70 @@ list_thread_priority_less(const struct list_elem *a, const struct list_elem *b,
   return ta->priority > tb->priority;
 }
 
+/* Does the MLFQS bookkeeping for a timer softirq.  The running
+   thread's priority is recomputed, since only its recent_cpu has
+   changed since the last time, unless the softirq was handed off
+   to ksoftirqd: then the running thread is ksoftirqd, not the
+   thread that used the ticks, and that one is refreshed on a
+   later tick instead.  If NEW_SECOND is true, first
+   updates the load average and decays the recent_cpu of the
+   running and ready threads; blocked threads catch up in
+   thread_mlfqs_refresh() when they wake.  Interrupts are off
+   for O(1) time on most ticks, but for O(ready threads) time
+   once a second: the once-a-second step is not O(1).  Making
+   it so would take a run queue per priority level, so that
+   ready threads could catch up on their decays lazily as
+   blocked ones do, instead of one sorted ready list. */
+void
+thread_mlfqs_update (bool new_second)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (softirq_context ());
+
+  old_level = intr_disable ();
+  if (new_second)
+    {
+      struct list_elem *e;
+
+      thread_update_load_avg (true);
+      for (e = list_begin (&ready_list); e != list_end (&ready_list);
+           e = list_next (e))
+        thread_mlfqs_refresh (list_entry (e, struct thread, elem));
+      list_sort (&ready_list, list_thread_priority_less, NULL);
+    }
+  if (cur != idle_thread && !softirq_in_ksoftirqd ())
+    thread_mlfqs_refresh (cur);
+  intr_set_level (old_level);
+}
+
+/* Applies to T the recent_cpu decays for the seconds that have
+   passed since T's last one, then recomputes T's priority.  Does
+   not reposition T in any list.  Must be called with interrupts
+   off. */
+void
+thread_mlfqs_refresh (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (load_avg_seconds - t->recent_cpu_seconds > LOAD_AVG_HISTORY)
+    {
+      int64_t first = load_avg_seconds - LOAD_AVG_HISTORY;
+      uint32_t oldest = load_avg_history[(first + 1) % LOAD_AVG_HISTORY];
+
+      decay_recent_cpu_span (t, oldest, first - t->recent_cpu_seconds);
+      t->recent_cpu_seconds = first;
+    }
+  while (t->recent_cpu_seconds < load_avg_seconds)
+    {
+      t->recent_cpu_seconds++;
+      decay_recent_cpu (t, load_avg_history[t->recent_cpu_seconds
+                                            % LOAD_AVG_HISTORY]);
+    }
+  thread_update_priority (t, NULL);
+}
+
 void
 thread_priority_sort (void)
 {
@@ -641,6 +919,8 @@ init_thread (struct thread *t, const char *name, int priority)
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
+  t->base_priority = priority;
+  list_init (&t->donations);
   t->magic = THREAD_MAGIC;
   list_push_back (&all_list, &t->allelem);
 
@@ -678,8 +958,8 @@ next_thread_to_run (void)
 {
   if (list_empty (&ready_list))
     return idle_thread;
-  else
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+  ready_cnt--;
+  return list_entry (list_pop_front (&ready_list), struct thread, elem);
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -724,7 +1004,7 @@ thread_schedule_tail (struct thread *prev)
   if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread) 
     {
       ASSERT (prev != cur);
-      palloc_free_page (prev);
+      thread_page_free (prev);
     }
 }
 
@@ -746,6 +1026,7 @@ schedule (void)
   ASSERT (cur->status != THREAD_RUNNING);
   ASSERT (is_thread (next));
 
+  TRACE (TRACE_SCHEDULE, next->tid);
   if (cur != next)
     prev = switch_threads (cur, next);
   thread_schedule_tail (prev);
@@ -755,14 +1036,51 @@ schedule (void)
 static tid_t
 allocate_tid (void) 
 {
-  static tid_t next_tid = 1;
-  tid_t tid;
+  static volatile uint32_t next_tid = 1;
 
-  lock_acquire (&tid_lock);
-  tid = next_tid++;
-  lock_release (&tid_lock);
+  return atomic_fetch_add (&next_tid, 1);
+}
 
-  return tid;
+/* Returns a page for a new thread, from the cache of exited
+   threads' pages if possible, or a null pointer if memory is not
+   available.  The page is not zeroed: init_thread() initializes
+   the struct thread, and the stack needs no initialization. */
+static struct thread *
+thread_page_get (void)
+{
+  enum intr_level old_level;
+  void *page;
+
+  old_level = intr_disable ();
+  page = thread_cache;
+  if (page != NULL)
+    {
+      thread_cache = *(void **) page;
+      thread_cache_cnt--;
+    }
+  intr_set_level (old_level);
+
+  if (page == NULL)
+    page = palloc_get_page (0);
+  return page;
+}
+
+/* Frees T's page, or keeps it for reuse by thread_page_get().
+   Must be called with interrupts off. */
+static void
+thread_page_free (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (thread_cache_cnt >= THREAD_CACHE_MAX)
+    {
+      palloc_free_page (t);
+      return;
+    }
+  t->magic = 0;
+  *(void **) t = thread_cache;
+  thread_cache = t;
+  thread_cache_cnt++;
 }
 
 /* Offset of `stack' member within `struct thread'.
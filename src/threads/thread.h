@@ -5,6 +5,9 @@
 #include <list.h>
 #include <stdint.h>
 #include "synch.h"
+#ifdef USERPROG
+#include "lib/user/syscall.h"
+#endif
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -94,11 +97,20 @@ struct thread
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    int priority;                       /* Priority. */
+    int priority;                       /* Priority, including donations. */
     struct list_elem allelem;           /* List element for all threads list. */
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
+
+    /* Priority donation, shared between thread.c and synch.c. */
+    int base_priority;                  /* Priority before donations. */
+    struct lock *wait_on_lock;          /* Lock being waited for, if any. */
+    struct list donations;              /* Threads waiting for our locks. */
+    struct list_elem donation_elem;     /* Element in holder's donations. */
+
+    /* Owned by thread.c. */
+    struct threadwrapper *timeout;      /* Sleep entry if waiting with timeout. */
    
     /* Project 2 file descriptor list. */
     struct list filelist;
@@ -124,10 +136,14 @@ struct thread
     uint32_t nice;
     /* Project 1 recent_cpu (17.14 fixed point format) */
     uint32_t recent_cpu;
+    int64_t recent_cpu_seconds;         /* Seconds of decay applied. */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
+
+    /* Owned by userprog/syscall.c. */
+    struct syscall_stat syscall_totals; /* System calls by this process. */
 #endif
 
     /* Owned by thread.c. */
@@ -146,6 +162,7 @@ struct threadwrapper
     struct thread *t;
     int64_t wakeup_time;
     struct list_elem threadelem;
+    bool timed_out;             /* Woken by the timer while waiting? */
   };
 
 
@@ -168,6 +185,7 @@ void thread_block (void);
 void thread_unblock (struct thread *);
 // Project 1. push thread to sleep
 void thread_sleep (int64_t ticks);
+bool thread_block_timeout (int64_t wakeup_time);
 void thread_aging (void);
 
 struct thread *thread_current (void);
@@ -176,6 +194,7 @@ const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
 void thread_yield (void);
+void thread_preempt (void);
 
 /* Performs some operation on thread t, given auxiliary data AUX. */
 typedef void thread_action_func (struct thread *t, void *aux);
@@ -183,6 +202,9 @@ void thread_foreach (thread_action_func *, void *);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
+void thread_donate_priority (struct thread *, int priority);
+void thread_recompute_priority (struct thread *);
+void thread_refresh_priority (void);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
@@ -195,5 +217,7 @@ void thread_update_priority (struct thread *t, void *aux);
 int thread_update_load_avg (bool update);
 bool list_thread_priority_less(const struct list_elem *a, const struct list_elem *b, void *aux);
 void thread_priority_sort (void);
+void thread_mlfqs_update (bool new_second);
+void thread_mlfqs_refresh (struct thread *t);
 
 #endif /* threads/thread.h */
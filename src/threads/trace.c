@@ -0,0 +1,256 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+#include "threads/vaddr.h"
+#ifdef FILESYS
+#include "devices/block.h"
+#endif
+
+/* Number of pages in each trace buffer.  The number of records
+   that fit must be a power of 2, so this must be too. */
+#define TRACE_PAGES 32
+
+/* Number of records in each trace buffer. */
+#define TRACE_RECORD_CNT \
+        (TRACE_PAGES * PGSIZE / sizeof (struct trace_record))
+
+/* Number of CPUs that we keep trace buffers for. */
+#define TRACE_CPU_CNT 1
+
+/* Magic number at the start of a trace dumped to a block
+   device: "PINTRACE" in little-endian byte order. */
+#define TRACE_MAGIC 0x45434152544e4950ULL
+
+/* A trace buffer.  There is one per CPU, so recording an event
+   needs no lock, just a brief window with interrupts off to
+   claim a slot. */
+struct trace_buffer
+  {
+    struct trace_record *records;       /* TRACE_RECORD_CNT records. */
+    uint32_t next;                      /* Number of records logged. */
+  };
+
+/* Header of a trace dumped to a block device, in its own
+   sector, followed by the records themselves. */
+struct trace_header
+  {
+    uint64_t magic;                     /* TRACE_MAGIC. */
+    uint32_t cpu;                       /* CPU number. */
+    uint32_t record_cnt;                /* Number of records that follow. */
+    uint32_t lost_cnt;                  /* Records overwritten. */
+    uint32_t event_cnt;                 /* Number of event names. */
+    char event_names[TRACE_EVENT_CNT][16]; /* Event names. */
+  };
+
+/* Names of events, indexed by enum trace_event. */
+static const char *event_names[TRACE_EVENT_CNT] =
+  {
+    "schedule",
+    "block",
+    "unblock",
+    "sema-down",
+    "sema-up",
+    "intr-enter",
+    "intr-exit",
+    "page-fault",
+    "syscall-enter",
+    "syscall-exit",
+    "block-read",
+    "block-write",
+  };
+
+/* Trace buffers, indexed by CPU number. */
+static struct trace_buffer buffers[TRACE_CPU_CNT];
+
+/* Is tracing enabled?  Set by trace_init() if requested. */
+bool trace_enabled;
+
+/* Set by trace_configure() from the kernel command line. */
+static bool trace_requested;
+static enum trace_sink trace_sink;
+
+static tid_t running_tid (void);
+static void dump_serial (int cpu, const struct trace_buffer *);
+#ifdef FILESYS
+static bool dump_scratch (int cpu, const struct trace_buffer *,
+                          block_sector_t *sector);
+#endif
+
+/* Requests tracing, with the trace to be dumped to SINK at power
+   off.  Takes effect in trace_init(). */
+void
+trace_configure (enum trace_sink sink)
+{
+  trace_requested = true;
+  trace_sink = sink;
+}
+
+/* Allocates the trace buffers and enables tracing, if tracing
+   was requested.  Must be called after palloc_init(). */
+void
+trace_init (void)
+{
+  int cpu;
+
+  if (!trace_requested)
+    return;
+
+  for (cpu = 0; cpu < TRACE_CPU_CNT; cpu++)
+    {
+      struct trace_buffer *b = &buffers[cpu];
+      b->records = palloc_get_multiple (PAL_ASSERT, TRACE_PAGES);
+      b->next = 0;
+    }
+  trace_enabled = true;
+}
+
+/* Appends a record for EVENT with argument ARG to the running
+   CPU's trace buffer, overwriting the oldest record if the
+   buffer is full.  Use the TRACE macro instead of calling this
+   directly. */
+void
+trace_log (enum trace_event event, uint32_t arg)
+{
+  struct trace_buffer *b = &buffers[0];
+  struct trace_record *r;
+  enum intr_level old_level;
+
+  ASSERT (event < TRACE_EVENT_CNT);
+
+  old_level = intr_disable ();
+  r = &b->records[b->next++ % TRACE_RECORD_CNT];
+  r->tsc = rdtsc ();
+  r->event = event;
+  r->tid = running_tid ();
+  r->arg = arg;
+  intr_set_level (old_level);
+}
+
+/* Disables tracing and writes out the contents of the trace
+   buffers to the configured sink. */
+void
+trace_dump (void)
+{
+#ifdef FILESYS
+  block_sector_t sector = 0;
+#endif
+  int cpu;
+
+  if (!trace_enabled)
+    return;
+  trace_enabled = false;
+
+  for (cpu = 0; cpu < TRACE_CPU_CNT; cpu++)
+    {
+      const struct trace_buffer *b = &buffers[cpu];
+#ifdef FILESYS
+      if (trace_sink == TRACE_SCRATCH && dump_scratch (cpu, b, &sector))
+        continue;
+#endif
+      dump_serial (cpu, b);
+    }
+}
+
+/* Returns the running thread's tid.  Unlike thread_tid(), works
+   in the middle of a context switch, when the running thread's
+   status is not THREAD_RUNNING. */
+static tid_t
+running_tid (void)
+{
+  uint32_t *esp;
+  struct thread *t;
+
+  asm ("mov %%esp, %0" : "=g" (esp));
+  t = pg_round_down (esp);
+  return t->tid;
+}
+
+/* Returns the index of the oldest record in B that has not
+   been overwritten. */
+static uint32_t
+first_record (const struct trace_buffer *b)
+{
+  return b->next > TRACE_RECORD_CNT ? b->next - TRACE_RECORD_CNT : 0;
+}
+
+/* Prints trace buffer B, for CPU number CPU, to the console.
+   To keep the output compact, each record goes on one line,
+   with its time stamp given relative to the previous record. */
+static void
+dump_serial (int cpu, const struct trace_buffer *b)
+{
+  uint32_t first = first_record (b);
+  uint64_t prev_tsc = 0;
+  uint32_t i;
+  int e;
+
+  printf ("trace: begin cpu %d, %"PRIu32" records, %"PRIu32" lost\n",
+          cpu, b->next - first, first);
+  for (e = 0; e < TRACE_EVENT_CNT; e++)
+    printf ("trace: event %d %s\n", e, event_names[e]);
+  for (i = first; i != b->next; i++)
+    {
+      const struct trace_record *r = &b->records[i % TRACE_RECORD_CNT];
+      printf ("T %"PRIx64" %x %x %"PRIx32"\n",
+              r->tsc - prev_tsc, r->event, r->tid, r->arg);
+      prev_tsc = r->tsc;
+    }
+  printf ("trace: end\n");
+}
+
+#ifdef FILESYS
+/* Writes trace buffer B, for CPU number CPU, to the scratch
+   device starting at *SECTOR, and advances *SECTOR past it.
+   Returns true if successful, false if there is no scratch
+   device or it is too small. */
+static bool
+dump_scratch (int cpu, const struct trace_buffer *b, block_sector_t *sector)
+{
+  struct block *scratch = block_get_role (BLOCK_SCRATCH);
+  uint32_t first = first_record (b);
+  uint32_t cnt = b->next - first;
+  size_t per_sector = BLOCK_SECTOR_SIZE / sizeof (struct trace_record);
+  struct trace_record buf[BLOCK_SECTOR_SIZE / sizeof (struct trace_record)];
+  struct trace_header *h = (struct trace_header *) buf;
+  uint32_t i;
+  int e;
+
+  if (scratch == NULL
+      || block_size (scratch) < *sector + 1 + DIV_ROUND_UP (cnt, per_sector))
+    {
+      printf ("trace: scratch device missing or too small\n");
+      return false;
+    }
+
+  memset (buf, 0, sizeof buf);
+  h->magic = TRACE_MAGIC;
+  h->cpu = cpu;
+  h->record_cnt = cnt;
+  h->lost_cnt = first;
+  h->event_cnt = TRACE_EVENT_CNT;
+  for (e = 0; e < TRACE_EVENT_CNT; e++)
+    strlcpy (h->event_names[e], event_names[e], sizeof h->event_names[e]);
+  block_write (scratch, (*sector)++, buf);
+
+  for (i = 0; i < cnt; i += per_sector)
+    {
+      size_t j;
+
+      memset (buf, 0, sizeof buf);
+      for (j = 0; j < per_sector && i + j < cnt; j++)
+        buf[j] = b->records[(first + i + j) % TRACE_RECORD_CNT];
+      block_write (scratch, (*sector)++, buf);
+    }
+
+  printf ("trace: wrote %"PRIu32" records for cpu %d to %s\n",
+          cnt, cpu, block_name (scratch));
+  return true;
+}
+#endif
@@ -0,0 +1,70 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Kernel event tracing.
+
+   When enabled with the "-trace" kernel command-line option,
+   hooks throughout the kernel append fixed-size binary records
+   to an in-memory trace buffer.  Each record is stamped with the
+   time-stamp counter and the running thread's tid.  The buffer
+   wraps around, keeping only the most recent records, and is
+   dumped at power off for decoding by utils/pintos-trace.
+
+   When tracing is disabled, each hook costs a load and a
+   branch. */
+
+/* Trace event IDs.  The name of each event is written into the
+   dump by trace_dump(), so the decoder does not depend on this
+   order. */
+enum trace_event
+  {
+    TRACE_SCHEDULE,             /* Context switch; ARG is next tid. */
+    TRACE_BLOCK,                /* thread_block(). */
+    TRACE_UNBLOCK,              /* thread_unblock(); ARG is its tid. */
+    TRACE_SEMA_DOWN,            /* sema_down(); ARG is semaphore. */
+    TRACE_SEMA_UP,              /* sema_up(); ARG is semaphore. */
+    TRACE_INTR_ENTER,           /* Interrupt entry; ARG is vector. */
+    TRACE_INTR_EXIT,            /* Interrupt exit; ARG is vector. */
+    TRACE_PAGE_FAULT,           /* Page fault; ARG is fault address. */
+    TRACE_SYSCALL_ENTER,        /* System call; ARG is call number. */
+    TRACE_SYSCALL_EXIT,         /* System call return; ARG is eax. */
+    TRACE_BLOCK_READ,           /* block_read(); ARG is sector. */
+    TRACE_BLOCK_WRITE,          /* block_write(); ARG is sector. */
+    TRACE_EVENT_CNT             /* Number of event IDs. */
+  };
+
+/* A trace record.  16 bytes. */
+struct trace_record
+  {
+    uint64_t tsc;               /* Time-stamp counter. */
+    uint16_t event;             /* A TRACE_* event ID. */
+    uint16_t tid;               /* Running thread's tid. */
+    uint32_t arg;               /* Event-specific argument. */
+  };
+
+/* Where trace_dump() writes the trace buffer. */
+enum trace_sink
+  {
+    TRACE_SERIAL,               /* Console, as text. */
+    TRACE_SCRATCH               /* Scratch block device, as binary. */
+  };
+
+extern bool trace_enabled;
+
+void trace_configure (enum trace_sink);
+void trace_init (void);
+void trace_log (enum trace_event, uint32_t arg);
+void trace_dump (void);
+
+/* Appends a record for EVENT with argument ARG to the trace
+   buffer, if tracing is enabled. */
+#define TRACE(EVENT, ARG)                                       \
+        do {                                                    \
+          if (trace_enabled)                                    \
+            trace_log (EVENT, (uint32_t) (ARG));                \
+        } while (0)
+
+#endif /* threads/trace.h */
@@ -0,0 +1,16 @@
+#ifndef THREADS_TSC_H
+#define THREADS_TSC_H
+
+#include <stdint.h>
+
+/* Reads and returns the CPU's time-stamp counter, which counts
+   clock cycles since reset.  See [IA32-v2b] "RDTSC". */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+#endif /* threads/tsc.h */
@@ -0,0 +1,329 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* All work queues, for statistics.
+   Access with interrupts off. */
+static struct list all_queues = LIST_INITIALIZER (all_queues);
+
+/* Delayed work items of every queue, ordered by wakeup tick.
+   Access with interrupts off. */
+static struct list delayed_list = LIST_INITIALIZER (delayed_list);
+
+static thread_func worker_thread NO_RETURN;
+static void queue_pending (struct workqueue *, struct work *);
+static bool wakeup_less (const struct list_elem *, const struct list_elem *,
+                         void *aux);
+static bool is_running (const struct workqueue *, const struct work *);
+static void wait_for_progress (struct workqueue *);
+static void wake_waiters (struct workqueue *);
+
+/* Initializes WQ as a work queue named NAME and starts
+   WORKER_CNT worker threads for it at the given PRIORITY.
+   Returns true if successful, false if not all of the workers
+   could be created; the queue is usable, with fewer workers, as
+   long as at least one was. */
+bool
+workqueue_init (struct workqueue *wq, const char *name,
+                int worker_cnt, int priority)
+{
+  enum intr_level old_level;
+  int i;
+
+  ASSERT (wq != NULL);
+  ASSERT (name != NULL);
+  ASSERT (worker_cnt > 0 && worker_cnt <= WORKQUEUE_WORKERS_MAX);
+  ASSERT (priority >= PRI_MIN && priority <= PRI_MAX);
+
+  wq->name = name;
+  list_init (&wq->pending);
+  sema_init (&wq->ready, 0);
+  list_init (&wq->waiters);
+  wq->worker_cnt = 0;
+  wq->running = 0;
+  wq->submitted = wq->completed = 0;
+  wq->backlog = wq->max_backlog = 0;
+  wq->total_latency_ns = wq->max_latency_ns = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&all_queues, &wq->allelem);
+  intr_set_level (old_level);
+
+  for (i = 0; i < worker_cnt; i++)
+    {
+      struct worker *w = &wq->workers[wq->worker_cnt];
+
+      w->wq = wq;
+      w->current = NULL;
+      if (thread_create (name, priority, worker_thread, w) == TID_ERROR)
+        break;
+      wq->worker_cnt++;
+    }
+  return wq->worker_cnt == worker_cnt;
+}
+
+/* Waits until every work item queued in WQ has run to
+   completion.  Delayed items whose delay has not yet expired are
+   not waited for.  Must not be called by one of WQ's workers. */
+void
+workqueue_flush (struct workqueue *wq)
+{
+  enum intr_level old_level;
+
+  ASSERT (!intr_context ());
+
+  old_level = intr_disable ();
+  while (!list_empty (&wq->pending) || wq->running > 0)
+    wait_for_progress (wq);
+  intr_set_level (old_level);
+}
+
+/* Queues the delayed work items whose delay has expired as of
+   timer tick NOW.  Called by the timer interrupt handler. */
+void
+workqueue_tick (int64_t now)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (!list_empty (&delayed_list))
+    {
+      struct work *work = list_entry (list_front (&delayed_list),
+                                      struct work, elem);
+      if (work->wakeup > now)
+        break;
+      list_pop_front (&delayed_list);
+      queue_pending (work->wq, work);
+    }
+}
+
+/* Prints statistics for each work queue. */
+void
+workqueue_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_queues); e != list_end (&all_queues);
+       e = list_next (e))
+    {
+      struct workqueue *wq = list_entry (e, struct workqueue, allelem);
+      uint64_t avg_ns = (wq->completed > 0
+                         ? wq->total_latency_ns / wq->completed : 0);
+
+      printf ("Workqueue %s: %"PRIu64" submitted, %"PRIu64" completed, "
+              "%u max backlog, %"PRIu64" us avg latency, "
+              "%"PRIu64" us max latency\n",
+              wq->name, wq->submitted, wq->completed, wq->max_backlog,
+              avg_ns / 1000, wq->max_latency_ns / 1000);
+    }
+}
+
+/* Initializes WORK to call FUNC, passing AUX, when run. */
+void
+work_init (struct work *work, work_func *func, void *aux)
+{
+  ASSERT (work != NULL);
+  ASSERT (func != NULL);
+
+  work->func = func;
+  work->aux = aux;
+  work->state = WORK_IDLE;
+  work->wq = NULL;
+}
+
+/* Queues WORK to be run by one of WQ's workers.  Returns true if
+   successful, false if WORK was already queued or delayed.  May
+   be called from an interrupt handler. */
+bool
+work_submit (struct workqueue *wq, struct work *work)
+{
+  enum intr_level old_level;
+  bool queued = false;
+
+  old_level = intr_disable ();
+  if (work->state == WORK_IDLE)
+    {
+      queue_pending (wq, work);
+      queued = true;
+    }
+  intr_set_level (old_level);
+  return queued;
+}
+
+/* Queues WORK to be run by one of WQ's workers after
+   approximately TICKS timer ticks.  Returns true if successful,
+   false if WORK was already queued or delayed.  May be called
+   from an interrupt handler. */
+bool
+work_submit_delayed (struct workqueue *wq, struct work *work, int64_t ticks)
+{
+  enum intr_level old_level;
+  bool queued = false;
+
+  if (ticks <= 0)
+    return work_submit (wq, work);
+
+  old_level = intr_disable ();
+  if (work->state == WORK_IDLE)
+    {
+      work->wq = wq;
+      work->state = WORK_DELAYED;
+      work->wakeup = timer_ticks () + ticks;
+      list_insert_ordered (&delayed_list, &work->elem, wakeup_less, NULL);
+      queued = true;
+    }
+  intr_set_level (old_level);
+  return queued;
+}
+
+/* Removes WORK from its queue, if it is queued or delayed, then
+   waits for any run of WORK already in progress to finish.
+   Returns true if WORK was removed before it could run, false if
+   it was not queued.  Must not be called by WORK's function. */
+bool
+work_cancel (struct work *work)
+{
+  struct workqueue *wq = work->wq;
+  enum intr_level old_level;
+  bool canceled = false;
+
+  ASSERT (!intr_context ());
+
+  if (wq == NULL)
+    return false;
+
+  old_level = intr_disable ();
+  if (work->state != WORK_IDLE)
+    {
+      list_remove (&work->elem);
+      if (work->state == WORK_PENDING)
+        wq->backlog--;
+      work->state = WORK_IDLE;
+      canceled = true;
+    }
+  while (is_running (wq, work))
+    wait_for_progress (wq);
+  intr_set_level (old_level);
+
+  return canceled;
+}
+
+/* Adds WORK to the pending list of WQ and wakes a worker.
+   Interrupts must be off. */
+static void
+queue_pending (struct workqueue *wq, struct work *work)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  work->wq = wq;
+  work->state = WORK_PENDING;
+  work->queued_ns = timer_now ();
+  list_push_back (&wq->pending, &work->elem);
+
+  wq->submitted++;
+  if (++wq->backlog > wq->max_backlog)
+    wq->max_backlog = wq->backlog;
+  sema_up (&wq->ready);
+}
+
+/* Worker thread: runs work items from the queue of the struct
+   worker passed as WORKER_, forever. */
+static void
+worker_thread (void *worker_)
+{
+  struct worker *worker = worker_;
+  struct workqueue *wq = worker->wq;
+
+  worker->thread = thread_current ();
+  for (;;)
+    {
+      enum intr_level old_level;
+      struct work *work;
+      work_func *func;
+      void *aux;
+      uint64_t latency;
+
+      sema_down (&wq->ready);
+
+      /* The item that WQ->READY counted may have been canceled. */
+      old_level = intr_disable ();
+      if (list_empty (&wq->pending))
+        {
+          intr_set_level (old_level);
+          continue;
+        }
+      work = list_entry (list_pop_front (&wq->pending), struct work, elem);
+      work->state = WORK_IDLE;
+      wq->backlog--;
+      wq->running++;
+      worker->current = work;
+
+      latency = timer_now () - work->queued_ns;
+      wq->total_latency_ns += latency;
+      if (latency > wq->max_latency_ns)
+        wq->max_latency_ns = latency;
+
+      /* WORK may be resubmitted or freed once FUNC starts. */
+      func = work->func;
+      aux = work->aux;
+      intr_set_level (old_level);
+
+      func (aux);
+
+      old_level = intr_disable ();
+      worker->current = NULL;
+      wq->running--;
+      wq->completed++;
+      wake_waiters (wq);
+      intr_set_level (old_level);
+    }
+}
+
+/* Returns true if delayed work item A wakes up before B. */
+static bool
+wakeup_less (const struct list_elem *a_, const struct list_elem *b_,
+             void *aux UNUSED)
+{
+  const struct work *a = list_entry (a_, struct work, elem);
+  const struct work *b = list_entry (b_, struct work, elem);
+
+  return a->wakeup < b->wakeup;
+}
+
+/* Returns true if one of WQ's workers is running WORK. */
+static bool
+is_running (const struct workqueue *wq, const struct work *work)
+{
+  int i;
+
+  for (i = 0; i < wq->worker_cnt; i++)
+    if (wq->workers[i].current == work)
+      return true;
+  return false;
+}
+
+/* Blocks the current thread until one of WQ's workers finishes
+   a work item.  Interrupts must be off. */
+static void
+wait_for_progress (struct workqueue *wq)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  list_push_back (&wq->waiters, &thread_current ()->elem);
+  thread_block ();
+}
+
+/* Wakes all the threads waiting on WQ in wait_for_progress().
+   Interrupts must be off. */
+static void
+wake_waiters (struct workqueue *wq)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (!list_empty (&wq->waiters))
+    thread_unblock (list_entry (list_pop_front (&wq->waiters),
+                                struct thread, elem));
+}
@@ -0,0 +1,89 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+
+/* Work queue: a pool of kernel threads that run deferred work.
+
+   A subsystem that has work to do in the background, such as
+   writing back dirty data, embeds a struct work in its own data
+   and submits it to a work queue, whose worker threads call the
+   work's function in FIFO order.  Submitting does not allocate
+   memory and may be done from an interrupt handler, so it is
+   also the way for an interrupt handler to hand off work that
+   may sleep.
+
+   A work item is queued at most once at a time: submitting an
+   item that is already queued has no effect.  Once a worker
+   takes an item off the queue, the item may be submitted again,
+   even by its own function, and the function may free it. */
+
+typedef void work_func (void *aux);
+
+/* States of a work item. */
+enum work_state
+  {
+    WORK_IDLE,                  /* Not queued. */
+    WORK_DELAYED,               /* Waiting for its delay to expire. */
+    WORK_PENDING                /* Queued for a worker. */
+  };
+
+/* A work item. */
+struct work
+  {
+    struct list_elem elem;      /* Element in pending or delayed list. */
+    work_func *func;            /* Function to call. */
+    void *aux;                  /* Argument to FUNC. */
+    enum work_state state;      /* State. */
+    struct workqueue *wq;       /* Queue last submitted to. */
+    int64_t wakeup;             /* Tick when a delayed item is queued. */
+    uint64_t queued_ns;         /* timer_now() when queued. */
+  };
+
+/* Maximum number of worker threads in a queue. */
+#define WORKQUEUE_WORKERS_MAX 8
+
+/* A worker thread. */
+struct worker
+  {
+    struct workqueue *wq;       /* Queue served. */
+    struct thread *thread;      /* The worker thread. */
+    struct work *current;       /* Work item being run, if any. */
+  };
+
+/* A work queue. */
+struct workqueue
+  {
+    const char *name;           /* Name, for statistics. */
+    struct list_elem allelem;   /* Element in list of all queues. */
+    struct list pending;        /* Work items ready to run. */
+    struct semaphore ready;     /* Counts items added to PENDING. */
+    struct list waiters;        /* Threads in flush or cancel. */
+    struct worker workers[WORKQUEUE_WORKERS_MAX];
+    int worker_cnt;             /* Number of workers. */
+    int running;                /* Number of workers running an item. */
+
+    /* Statistics. */
+    uint64_t submitted;         /* Items queued. */
+    uint64_t completed;         /* Items run to completion. */
+    unsigned backlog;           /* Items in PENDING. */
+    unsigned max_backlog;       /* Largest BACKLOG seen. */
+    uint64_t total_latency_ns;  /* Total time from queued to started. */
+    uint64_t max_latency_ns;    /* Longest time from queued to started. */
+  };
+
+bool workqueue_init (struct workqueue *, const char *name,
+                     int worker_cnt, int priority);
+void workqueue_flush (struct workqueue *);
+void workqueue_tick (int64_t now);
+void workqueue_print_stats (void);
+
+void work_init (struct work *, work_func *, void *aux);
+bool work_submit (struct workqueue *, struct work *);
+bool work_submit_delayed (struct workqueue *, struct work *, int64_t ticks);
+bool work_cancel (struct work *);
+
+#endif /* threads/workqueue.h */
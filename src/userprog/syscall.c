@@ -3,6 +3,8 @@
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "threads/tsc.h"
 
 #include "lib/kernel/list.h"
 #include "devices/input.h"
@@ -12,18 +14,47 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/synch.h"
 
+/* Number of system calls. */
+#define SYSCALL_CNT (SYS_STATS + 1)
+
 static void syscall_handler (struct intr_frame *);
+static void syscall_account (int syscall_number, uint64_t start,
+                             const struct intr_frame *);
 // find file in filelist of current thread and return
 static struct file *find_file (int fd);
 // used lock for file synch
 static struct lock filelock;
+// cache of open file descriptors
+static struct kmem_cache filewrapper_cache;
+
+/* Statistics for each system call, across all processes. */
+static struct syscall_stat syscall_stats_table[SYSCALL_CNT];
+
+/* Names of system calls, for printing statistics. */
+static const char *syscall_names[SYSCALL_CNT] =
+  {
+    [SYS_HALT] = "halt", [SYS_EXIT] = "exit", [SYS_EXEC] = "exec",
+    [SYS_WAIT] = "wait", [SYS_CREATE] = "create", [SYS_REMOVE] = "remove",
+    [SYS_OPEN] = "open", [SYS_FILESIZE] = "filesize", [SYS_READ] = "read",
+    [SYS_WRITE] = "write", [SYS_SEEK] = "seek", [SYS_TELL] = "tell",
+    [SYS_CLOSE] = "close", [SYS_MMAP] = "mmap", [SYS_MUNMAP] = "munmap",
+    [SYS_CHDIR] = "chdir", [SYS_MKDIR] = "mkdir", [SYS_READDIR] = "readdir",
+    [SYS_ISDIR] = "isdir", [SYS_INUMBER] = "inumber", [SYS_FIBO] = "fibo",
+    [SYS_SUM4] = "sum4", [SYS_STATS] = "stats",
+  };
+
+/* Print a process's system call totals when it exits? */
+bool syscall_stats_on_exit;
 
 void
 syscall_init (void) 
 {
-  lock_init(&filelock);
+  lock_init_named (&filelock, "filelock");
+  kmem_cache_init(&filewrapper_cache, "filewrapper", sizeof (struct filewrapper),
+                  __alignof__ (struct filewrapper), NULL);
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
 }
 
@@ -35,6 +66,8 @@ syscall_handler (struct intr_frame *f)
   
   // TODO: clean up this mess.
   int syscall_number = *((int*)f->esp);
+  uint64_t start = rdtsc ();
+  TRACE (TRACE_SYSCALL_ENTER, syscall_number);
   switch(syscall_number)
   {
     case  SYS_HALT  : syscall_halt(); break;
@@ -75,8 +108,70 @@ syscall_handler (struct intr_frame *f)
                                                             *(int*)(f->esp+8),
                                                             *(int*)(f->esp+12),
                                                             *(int*)(f->esp+16)); break;
+    case  SYS_STATS : if(!is_user_vaddr(f->esp+8)) syscall_exit(-1);
+                      f->eax = syscall_stats(*(int*)(f->esp+4),
+                                             *(struct syscall_stat**)(f->esp+8)); break;
     default         : syscall_exit(-1);
   }
+  syscall_account (syscall_number, start, f);
+  TRACE (TRACE_SYSCALL_EXIT, f->eax);
+}
+
+/* Adds a call to SYSCALL_NUMBER, which started at TSC value
+   START and returned to user frame F, to the statistics for the
+   system call and for the running process.  Calls that do not
+   return, such as exit, are not counted. */
+static void
+syscall_account (int syscall_number, uint64_t start,
+                 const struct intr_frame *f)
+{
+  struct syscall_stat *stats[2];
+  uint64_t cycles = rdtsc () - start;
+  unsigned bytes = 0;
+  enum intr_level old_level;
+  int i;
+
+  if ((syscall_number == SYS_READ || syscall_number == SYS_WRITE)
+      && (int) f->eax > 0)
+    bytes = f->eax;
+
+  stats[0] = &syscall_stats_table[syscall_number];
+  stats[1] = &thread_current ()->syscall_totals;
+
+  /* Other processes update the same counters. */
+  old_level = intr_disable ();
+  for (i = 0; i < 2; i++)
+    {
+      struct syscall_stat *s = stats[i];
+      if (s->cnt == 0 || cycles < s->min_cycles)
+        s->min_cycles = cycles;
+      if (cycles > s->max_cycles)
+        s->max_cycles = cycles;
+      s->cnt++;
+      s->cycles += cycles;
+      s->bytes += bytes;
+    }
+  intr_set_level (old_level);
+}
+
+/* Prints statistics for each system call that has been made. */
+void
+syscall_print_stats (void)
+{
+  int i;
+
+  for (i = 0; i < SYSCALL_CNT; i++)
+    {
+      const struct syscall_stat *s = &syscall_stats_table[i];
+      if (s->cnt == 0)
+        continue;
+      printf ("Syscall %s: %llu calls, %llu cycles avg, %llu min, %llu max",
+              syscall_names[i], s->cnt, s->cycles / s->cnt,
+              s->min_cycles, s->max_cycles);
+      if (i == SYS_READ || i == SYS_WRITE)
+        printf (", %llu bytes", s->bytes);
+      printf ("\n");
+    }
 }
 
 // finder for file in list
@@ -136,7 +231,7 @@ syscall_exit (int status)
       struct list_elem *next = list_next(e);
       list_remove(e);
       file_close(fw->f);
-      free(fw);
+      kmem_cache_free(&filewrapper_cache, fw);
       e = next;
     }
   // close itself
@@ -144,6 +239,12 @@ syscall_exit (int status)
 
   // exit print.
   printf("%s: exit(%d)\n", current->name, status);
+  if(syscall_stats_on_exit)
+    {
+      const struct syscall_stat *s = &current->syscall_totals;
+      printf("%s: %llu syscalls, %llu cycles, %llu bytes read or written\n",
+             current->name, s->cnt, s->cycles, s->bytes);
+    }
   current->is_done = true;
   current->return_status = status;
   // wait for parent to take over the result
@@ -212,7 +313,14 @@ syscall_open (const char *file)
   // MAX FILE DESC.
   if(t->nextfd > MAX_FILE_FD) return -1;
   
-  struct filewrapper *fw = malloc(sizeof(struct filewrapper));
+  struct filewrapper *fw = kmem_cache_alloc(&filewrapper_cache);
+  if (fw == NULL)
+    {
+      lock_acquire(&filelock);
+      file_close(f);
+      lock_release(&filelock);
+      return -1;
+    }
   
   fw->f = f;
   fw->fd = t->nextfd++;
@@ -243,9 +351,7 @@ syscall_read (int fd, void *buf, unsigned size)
   // stdin
   if(fd==0)
     {
-      unsigned i;
-      for(i=0;i<size;++i)
-        *((uint8_t*) buf + i) = input_getc();
+      input_read(buf, size);
       return size;
     }
   else
@@ -341,7 +447,7 @@ syscall_close (int fd)
       list_entry(e, struct filewrapper, fileelem)->fd = fd;
     }
   list_remove(found);
-  free(list_entry(found, struct filewrapper, fileelem));
+  kmem_cache_free(&filewrapper_cache, list_entry(found, struct filewrapper, fileelem));
   current->nextfd--;
 }
 
@@ -360,3 +466,18 @@ syscall_sum_of_four_integers (int a, int b, int c, int d)
 {
   return a+b+c+d;
 }
+
+bool
+syscall_stats (int syscall_number, struct syscall_stat *stat)
+{
+  if(stat==NULL || !is_user_vaddr(stat) || !is_user_vaddr(stat+1))
+    syscall_exit(-1);
+
+  if(syscall_number==STATS_PROCESS)
+    *stat = thread_current()->syscall_totals;
+  else if(syscall_number>=0 && syscall_number<SYSCALL_CNT)
+    *stat = syscall_stats_table[syscall_number];
+  else
+    return false;
+  return true;
+}
@@ -5,7 +5,12 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/* Print a process's system call totals when it exits?
+   Controlled by kernel command-line option "-sstats". */
+extern bool syscall_stats_on_exit;
+
 void syscall_init (void);
+void syscall_print_stats (void);
 void syscall_halt (void);
 void syscall_exit (int status);
 pid_t syscall_exec (const char *cmdline);
@@ -21,5 +26,6 @@ int syscall_tell (int fd);
 void syscall_close (int fd);
 int syscall_fibonacci (int n);
 int syscall_sum_of_four_integers (int a, int b, int c, int d);
+bool syscall_stats (int syscall_number, struct syscall_stat *stat);
 
 #endif /* userprog/syscall.h */